@@ -0,0 +1,105 @@
+#include "lxSwappableArchive.h"
+#include <string.h>
+
+namespace lx {
+
+/*  ====================================================================================
+    SwappableSaver
+    ==================================================================================== */
+
+/*static*/
+size_t SwappableSaver::getAllocSize(size_t SwappableMaxCount) {
+    return SwappableMaxCount * sizeof(unsigned int);
+}
+
+bool SwappableSaver::init(void* alignPtr_buffer, size_t bufferSize, SwappableManager* mgr) {
+    if (bufferSize < getAllocSize(mgr->m_totalSwappable)) {
+        return false;
+    }
+
+    m_ids = (unsigned int*)alignPtr_buffer;
+    for (SwappableIndex n=0; n < mgr->m_totalSwappable; n++) {
+        m_ids[n] = NULL_ID;
+    }
+    return true;
+}
+
+/*static*/
+void SwappableSaver::clearReference(void* inImage) {
+    // Live pointer and links mean nothing once saved, the group is kept.
+    SwappableManager::SwappableInstance* instance = (SwappableManager::SwappableInstance*)inImage;
+    unsigned int group = SwappableManager::getGroup(instance);
+    memset(inImage, 0, sizeof(SwappableManager::SwappableInstance));
+    SwappableManager::setGroup(instance, group);
+}
+
+/*  ====================================================================================
+    SwappableLoader
+    ==================================================================================== */
+
+/*static*/
+size_t SwappableLoader::getAllocSize(size_t objectCount) {
+    return objectCount * (sizeof(CHAIN) + sizeof(SwappableIndex));
+}
+
+bool SwappableLoader::init(void* alignPtr_buffer, size_t bufferSize, size_t objectCount, SwappableManager* mgr) {
+    if (bufferSize < getAllocSize(objectCount)) {
+        return false;
+    }
+
+    m_mgr         = mgr;
+    m_chains      = (CHAIN*)alignPtr_buffer;
+    m_slots       = (SwappableIndex*)&m_chains[objectCount];
+    m_objectCount = objectCount;
+    for (size_t n=0; n < objectCount; n++) {
+        m_chains[n].m_first = 0;
+        m_chains[n].m_last  = 0;
+        m_slots[n]          = SwappableManager::NULL_IDX;
+    }
+    return true;
+}
+
+bool SwappableLoader::swizzle(void* imageBase, const SwappableFixup* fixups, size_t count) {
+    typedef SwappableManager::SwappableInstance Instance;
+
+    //
+    // Pass over the fixups : set the pointers and chain the references by target.
+    //
+    unsigned char*  base  = (unsigned char*)imageBase;
+    bool            valid = true;
+    for (size_t n=0; n < count; n++) {
+        const SwappableFixup& fixup = fixups[n];
+        SwappableIndex handle = (fixup.m_id < m_objectCount) ? m_slots[fixup.m_id] : SwappableManager::NULL_IDX;
+        if (handle == SwappableManager::NULL_IDX) {
+            valid = false;
+            continue;
+        }
+
+        // Image reference is NULL and unlinked : set it and push it on the chain.
+        CHAIN&    chain    = m_chains[fixup.m_id];
+        Instance* instance = (Instance*)(base + fixup.m_offset);
+        instance->ptr      = m_mgr->m_arrayList[handle].m_owner;
+        instance->next     = chain.m_first;
+        if (chain.m_first) {
+            SwappableManager::setPrevLink(chain.m_first, instance);
+        } else {
+            chain.m_last   = instance;
+        }
+        chain.m_first      = instance;
+    }
+
+    //
+    // One splice per target, chains are left empty for the next image.
+    //
+    for (size_t n=0; n < count; n++) {
+        unsigned int id = fixups[n].m_id;
+        if ((id < m_objectCount) && m_chains[id].m_first) {
+            m_mgr->spliceListStart(m_chains[id].m_first, m_chains[id].m_last, m_slots[id]);
+            m_chains[id].m_first = 0;
+            m_chains[id].m_last  = 0;
+        }
+    }
+    return valid;
+}
+
+} // End namespace lx
@@ -0,0 +1,145 @@
+/*
+// ====================================================================================
+//  Save and load of reference graphs, with pointer swizzling.
+//
+//    - Save : objects get an id, each hotswap_ptr copied into the saved image is
+//      cleared and described by a fixup { offset inside the image, id of the target }.
+//    - Load : the image is used in place (ie memory mapped, MAP_PRIVATE), objects
+//      are registered, then swizzle() walks the fixups once : each reference gets
+//      its pointer and is chained with the other references to the same target,
+//      each chain is then linked to its target list in one splice.
+//      No operator=, no allocation.
+//    - Fixups have a fixed 16 byte layout and can be stored next to the image.
+//    - User has to provide memory, no allocation is performed by the system.
+//
+//  Usage :
+//    // Save
+//    SwappableSaver saver;
+//    saver.init(buffer, SwappableSaver::getAllocSize(mgrCapacity), mgr);
+//    saver.setId(mesh, 0);                                 // Any id, ie index in the image.
+//    memcpy(&image->material, &material, sizeof(Material));
+//    if (saver.saveReference(material.mesh, &image->material.mesh, image, &fixups[count])) {
+//        count++;
+//    }
+//
+//    // Load
+//    SwappableLoader loader;
+//    loader.init(buffer, SwappableLoader::getAllocSize(objectCount), objectCount, mgr);
+//    loader.setObject(0, meshLoaded);                      // Registered objects, by id.
+//    loader.swizzle(mappedImage, fixups, count);
+//
+//  Note :
+//  - Ids are limited to 32 bits.
+//  - Image references must be in writable memory, they are linked to the live lists.
+//  - Reference groups (hotswap_ptr::setGroup) are saved with the references.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_ARCHIVE_H
+#define LX_SWAPPABLE_ARCHIVE_H
+
+#include "lxSwappablePointer.h"
+
+namespace lx {
+
+/* Saved reference : stored as is in files                                     */
+struct SwappableFixup {
+    unsigned long long  m_offset;                       // Offset of the hotswap_ptr inside the image.
+    unsigned int        m_id;                           // Id of the referenced object.
+    unsigned int        m_pad;
+};
+
+/*  ====================================================================================
+    Save side : live references to fixups.
+    ==================================================================================== */
+class SwappableSaver {
+public:
+    /* No id given to the object                                                */
+    static const unsigned int NULL_ID = 0xFFFFFFFF;
+
+    /* Function for the client to know how much memory is needed in advance before
+       doing calling the init(...) function. Capacity of the manager saved.     */
+    static
+    size_t  getAllocSize    (size_t SwappableMaxCount);
+
+    /* Setup the id table for the objects of the manager.
+       Return true if successful, false if memory was not big enough.            */
+    bool init            (void* alignPtr_buffer, size_t bufferSize, SwappableManager* mgr);
+
+    /* Give an id to an object, saved references to it resolve to this id.     */
+    template<class T>
+    void setId           (const T* obj, unsigned int id) {
+        m_ids[obj->_trackMe.getSlot()] = id;
+    }
+
+    /* Clear the copy of a reference inside the image and describe it in the fixup.
+       Return false if NULL or if the target has no id : nothing to fix, the
+       image reference stays NULL.                                               */
+    template<class T>
+    bool saveReference   (const hotswap_ptr<T>& live, hotswap_ptr<T>* inImage, const void* imageBase, SwappableFixup* fixup) const {
+        clearReference(inImage);
+        const void* owner = live.instance.ptr;
+        if (owner) {
+            unsigned int id = m_ids[SwappableCast<T>::tracker(owner).getSlot()];
+            if (id != NULL_ID) {
+                fixup->m_offset = (unsigned long long)((const unsigned char*)inImage - (const unsigned char*)imageBase);
+                fixup->m_id     = id;
+                fixup->m_pad    = 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static
+    void    clearReference  (void* inImage);
+
+    unsigned int*       m_ids;                          // Id by manager entry.
+};
+
+/*  ====================================================================================
+    Load side : fixups to linked references.
+    ==================================================================================== */
+class SwappableLoader {
+public:
+    /* Function for the client to know how much memory is needed in advance before
+       doing calling the init(...) function */
+    static
+    size_t  getAllocSize    (size_t objectCount);
+
+    /* Setup the table for objectCount ids, objects registered in the manager.
+       Return true if successful, false if memory was not big enough.            */
+    bool init            (void* alignPtr_buffer, size_t bufferSize, size_t objectCount, SwappableManager* mgr);
+
+    /* Object loaded for an id, must be registered in the manager.
+       Return false if the id is not below the count given to init.            */
+    template<class T>
+    bool setObject       (unsigned int id, T* obj) {
+        if (id < m_objectCount) {
+            m_slots[id] = obj->_trackMe.getSlot();
+            return true;
+        }
+        return false;
+    }
+
+    /* Link all the references of the image in a single pass.
+       Return false if a fixup uses an id without object : it is left NULL.    */
+    bool swizzle         (void* imageBase, const SwappableFixup* fixups, size_t count);
+
+private:
+    /* References of the image to one object, chained during the pass          */
+    struct CHAIN {
+        SwappableManager::SwappableInstance*    m_first;
+        SwappableManager::SwappableInstance*    m_last;
+    };
+
+    SwappableManager*   m_mgr;
+    CHAIN*              m_chains;                       // Chain by id, empty between swizzles.
+    SwappableIndex*     m_slots;                        // Manager entry by id.
+    size_t              m_objectCount;
+};
+
+};
+
+#endif
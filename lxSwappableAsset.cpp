@@ -0,0 +1,177 @@
+#include "lxSwappableAsset.h"
+
+#ifdef __linux__
+
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+namespace lx {
+
+/*static*/
+size_t SwappableAssetWatcher::getAllocSize(int maxAssets) {
+    return maxAssets * sizeof(ASSET);
+}
+
+bool SwappableAssetWatcher::init(void* alignPtr_buffer, size_t bufferSize, int maxAssets, SwappableManager* mgr) {
+    if (bufferSize < getAllocSize(maxAssets)) {
+        return false;
+    }
+
+    m_fd                = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        return false;
+    }
+    m_assets            = (ASSET*)alignPtr_buffer;
+    m_mgr               = mgr;
+    m_maxAssets         = maxAssets;
+    m_assetCount        = 0;
+    return true;
+}
+
+void SwappableAssetWatcher::release() {
+    // Closing the instance removes all the watches.
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_assetCount = 0;
+}
+
+bool SwappableAssetWatcher::watch(const char* path, Swappable* current, BuildFunc build, SwappableDestroyFunc destroy, void* context) {
+    size_t length = strlen(path);
+    if ((m_assetCount == m_maxAssets) || (length >= (size_t)MAX_PATH_LENGTH)) {
+        return false;
+    }
+
+    //
+    // Watch the directory : a file replaced by a rename is a new inode,
+    // a watch on the file itself would be lost.
+    //
+    char directory[MAX_PATH_LENGTH];
+    const char* slash = strrchr(path, '/');
+    int nameStart;
+    if (slash) {
+        nameStart = (int)(slash - path) + 1;
+        size_t dirLength = (slash == path) ? 1 : (size_t)(slash - path);
+        memcpy(directory, path, dirLength);
+        directory[dirLength] = 0;
+    } else {
+        nameStart = 0;
+        directory[0] = '.';
+        directory[1] = 0;
+    }
+
+    // Same directory gives the same descriptor.
+    int wd = inotify_add_watch(m_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        return false;
+    }
+
+    ASSET& asset        = m_assets[m_assetCount++];
+    memcpy(asset.m_path, path, length + 1);
+    asset.m_current     = current;
+    asset.m_build       = build;
+    asset.m_destroy     = destroy;
+    asset.m_context     = context;
+    asset.m_watch       = wd;
+    asset.m_nameStart   = nameStart;
+    asset.m_pending     = false;
+    asset.m_dirty       = false;
+    return true;
+}
+
+int SwappableAssetWatcher::poll() {
+    // Aligned for the event records.
+    union {
+        struct inotify_event    event;
+        char                    bytes[4096];
+    } buffer;
+
+    ssize_t readSize;
+    while ((readSize = read(m_fd, buffer.bytes, sizeof(buffer.bytes))) > 0) {
+        for (ssize_t pos = 0; pos < readSize; ) {
+            const struct inotify_event* event = (const struct inotify_event*)&buffer.bytes[pos];
+            if (event->len) {
+                for (int n=0; n < m_assetCount; n++) {
+                    ASSET& asset = m_assets[n];
+                    if ((asset.m_watch == event->wd) && (strcmp(event->name, &asset.m_path[asset.m_nameStart]) == 0)) {
+                        asset.m_dirty = true;
+                    }
+                }
+            }
+            pos += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    // A file changed while its swap is queued waits for the drain.
+    int queued = 0;
+    for (int n=0; n < m_assetCount; n++) {
+        ASSET& asset = m_assets[n];
+        if (asset.m_dirty && !asset.m_pending) {
+            asset.m_dirty = false;
+            if (load(asset)) {
+                queued++;
+            }
+        }
+    }
+    return queued;
+}
+
+bool SwappableAssetWatcher::load(ASSET& asset) {
+    int fd = open(asset.m_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if ((fstat(fd, &info) != 0) || (info.st_size == 0)) {
+        close(fd);
+        return false;
+    }
+
+    // Mapping stays valid after close.
+    size_t size = (size_t)info.st_size;
+    void*  data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    Swappable* built = asset.m_build(asset.m_context, data, size);
+    if (!built) {
+        munmap(data, size);
+        return false;
+    }
+
+    SwappableManager::SwapRequest& request = asset.m_request;
+    request.m_oldInstance   = asset.m_current;
+    request.m_newInstance   = built;
+    request.m_onDone        = &SwappableAssetWatcher::onSwapDone;
+    request.m_retireOld     = asset.m_destroy;
+    request.m_userData      = &asset;
+    asset.m_pending         = true;
+    m_mgr->queueSwap(&request);
+    return true;
+}
+
+/*static*/
+void SwappableAssetWatcher::onSwapDone(SwappableManager::SwapRequest* request) {
+    ASSET* asset        = (ASSET*)request->m_userData;
+    asset->m_current    = request->m_newInstance;
+    asset->m_pending    = false;
+}
+
+/*static*/
+void SwappableAssetWatcher::unmap(const void* data, size_t size) {
+    if (data) {
+        munmap((void*)data, size);
+    }
+}
+
+} // End namespace lx
+
+#endif
@@ -0,0 +1,149 @@
+/*
+// ====================================================================================
+//  Hot reload of data assets from files (Linux).
+//
+//    - Files are watched with inotify : the parent directory is watched, so editors
+//      saving through a temporary file and a rename are seen too.
+//    - A changed file is memory mapped (read only, private) and the user build
+//      function creates the new asset over the mapping, without copying the data.
+//    - The swap is queued in the manager : it happens at the next drainSwaps(),
+//      then the old asset goes through the manager retire path (ie SwappableHazard,
+//      SwappableRetireQueue) and its mapping is removed when it is destroyed.
+//    - User has to provide memory, no allocation is performed by the system.
+//
+//  Usage :
+//    class Texture : public SwappableMappedAsset {
+//        MAKESWAPPABLE(Texture)
+//        ...
+//    };
+//
+//    Swappable* buildTexture(void* context, const void* data, size_t size) {
+//        Texture* tex = new Texture((SwappableManager*)context, data, size);
+//        tex->m_data  = data;                              // Unmapped with the texture.
+//        tex->m_size  = size;
+//        return &tex->_trackMe;
+//    }
+//
+//    SwappableAssetWatcher watcher;
+//    watcher.init(buffer, SwappableAssetWatcher::getAllocSize(64), 64, mgr);
+//    watcher.watch("data/wall.tex", &wall->_trackMe, &buildTexture,
+//                  &SwappableAssetWatcher::destroyAsset<Texture>, mgr);
+//
+//    // Each frame, from the thread owning the manager :
+//    watcher.poll();
+//    mgr->drainSwaps();
+//
+//  Note :
+//  - The asset given to watch() is destroyed by the same function when replaced.
+//  - A change seen while the previous swap is still queued is loaded after it.
+//  - Files must be replaced (written aside and renamed), not rewritten in place :
+//    a mapped file truncated under a reader faults.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_ASSET_H
+#define LX_SWAPPABLE_ASSET_H
+
+#include "lxSwappablePointer.h"
+
+namespace lx {
+
+/* Base of an asset built over a mapped file : the mapping is removed with the asset.
+   Stays NULL for assets which are not mapped.                                 */
+struct SwappableMappedAsset {
+    SwappableMappedAsset()
+    :m_data (0)
+    ,m_size (0)
+    {
+    }
+
+    const void*         m_data;                         // Start of the mapping.
+    size_t              m_size;                         // Size of the mapping.
+};
+
+/*  ====================================================================================
+    File watcher swapping assets on change.
+    ==================================================================================== */
+class SwappableAssetWatcher {
+public:
+    /* Build a new asset over the file data, return its tracker or NULL if the
+       data is invalid (current asset is kept).                                  */
+    typedef Swappable* (*BuildFunc)(void* context, const void* data, size_t size);
+
+    static const int    MAX_PATH_LENGTH = 256;
+
+    SwappableAssetWatcher()
+    :m_assets       (0)
+    ,m_mgr          (0)
+    ,m_maxAssets    (0)
+    ,m_assetCount   (0)
+    ,m_fd           (-1)
+    {
+    }
+
+    /* Function for the client to know how much memory is needed in advance before
+       doing calling the init(...) function */
+    static
+    size_t  getAllocSize    (int maxAssets);
+
+    /* Setup buffer used for the watched assets and open the inotify instance.
+       Return false if memory was not big enough or inotify is not available.   */
+    bool init            (void* alignPtr_buffer, size_t bufferSize, int maxAssets, SwappableManager* mgr);
+
+    /* Stop watching. Queued swaps must have been drained.                      */
+    void release         ();
+
+    /* Watch a file, current is the asset loaded from it.
+       Return false if full, path too long or the directory can not be watched. */
+    bool watch           (const char* path, Swappable* current, BuildFunc build, SwappableDestroyFunc destroy, void* context);
+
+    /* Read the file events without blocking, load the changed files and queue
+       their swaps. Return the number of swaps queued.                          */
+    int  poll            ();
+
+    /* inotify descriptor, to wait for changes with select/poll/epoll          */
+    int  getDescriptor   () const { return m_fd; }
+
+    /* Destroy function for assets deriving from SwappableMappedAsset           */
+    template<class T>
+    static void destroyAsset(void* object) {
+        T*          asset = SwappableCast<T>::fromOwner(object);
+        const void* data  = static_cast<SwappableMappedAsset*>(asset)->m_data;
+        size_t      size  = static_cast<SwappableMappedAsset*>(asset)->m_size;
+        delete asset;
+        unmap(data, size);
+    }
+
+private:
+    struct ASSET {
+        SwappableManager::SwapRequest   m_request;      // Queued swap, m_userData is the asset.
+        Swappable*                      m_current;      // Asset in use.
+        BuildFunc                       m_build;
+        SwappableDestroyFunc            m_destroy;
+        void*                           m_context;
+        int                             m_watch;        // Watch descriptor of the directory.
+        int                             m_nameStart;    // File name inside m_path.
+        bool                            m_pending;      // Swap queued, not drained yet.
+        bool                            m_dirty;        // File changed since last load.
+        char                            m_path[MAX_PATH_LENGTH];
+    };
+
+    static
+    void    unmap           (const void* data, size_t size);
+
+    static
+    void    onSwapDone      (SwappableManager::SwapRequest* request);
+
+    /* Map the file and queue the swap, false if the file or the data is invalid */
+    bool    load            (ASSET& asset);
+
+    ASSET*              m_assets;
+    SwappableManager*   m_mgr;
+    int                 m_maxAssets;
+    int                 m_assetCount;
+    int                 m_fd;                           // inotify instance.
+};
+
+};
+
+#endif
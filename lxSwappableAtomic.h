@@ -0,0 +1,57 @@
+/*
+// ====================================================================================
+//  Minimal atomic helpers for the hot-swappable smart pointer library.
+//
+//    - Acquire loads, release stores and fences on aligned words/pointers.
+//    - Works without C++11 : compiler builtins on GCC/Clang, volatile semantic on MSVC.
+//    - On x86 acquire/release compile to plain moves, only the compiler is constrained.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_ATOMIC_H
+#define LX_SWAPPABLE_ATOMIC_H
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+namespace lx {
+
+struct SwappableAtomic {
+#if defined(__GNUC__) || defined(__clang__)
+    template<class T> static inline T    loadAcquire (const T* p)       { return __atomic_load_n (p, __ATOMIC_ACQUIRE);       }
+    template<class T> static inline T    loadRelaxed (const T* p)       { return __atomic_load_n (p, __ATOMIC_RELAXED);       }
+    template<class T> static inline void storeRelease(T* p, T value)    {        __atomic_store_n(p, value, __ATOMIC_RELEASE); }
+    template<class T> static inline void storeRelaxed(T* p, T value)    {        __atomic_store_n(p, value, __ATOMIC_RELAXED); }
+    template<class T> static inline T    fetchAdd    (T* p, T value)    { return __atomic_fetch_add(p, value, __ATOMIC_ACQ_REL); }
+    template<class T> static inline bool compareExchange(T* p, T expected, T desired) {
+        return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+                      static inline void fence       ()                 {        __atomic_thread_fence(__ATOMIC_SEQ_CST);      }
+#elif defined(_MSC_VER)
+    // MSVC volatile accesses have acquire/release semantic (/volatile:ms, default on x86/x64).
+    template<class T> static inline T    loadAcquire (const T* p)       { return *(const volatile T*)p;  }
+    template<class T> static inline T    loadRelaxed (const T* p)       { return *(const volatile T*)p;  }
+    template<class T> static inline void storeRelease(T* p, T value)    { *(volatile T*)p = value;       }
+    template<class T> static inline void storeRelaxed(T* p, T value)    { *(volatile T*)p = value;       }
+    template<class T> static inline T    fetchAdd    (T* p, T value)    {
+        T old = *(volatile T*)p;
+        while (!compareExchange(p, old, (T)(old + value))) { old = *(volatile T*)p; }
+        return old;
+    }
+    template<class T> static inline bool compareExchange(T* p, T expected, T desired) {
+        if (sizeof(T) == 8) {
+            return _InterlockedCompareExchange64((volatile __int64*)p, (__int64)desired, (__int64)expected) == (__int64)expected;
+        } else {
+            return _InterlockedCompareExchange  ((volatile long*   )p, (long   )desired, (long   )expected) == (long   )expected;
+        }
+    }
+                      static inline void fence       ()                 { long barrier = 0; _InterlockedExchange(&barrier, 1); }
+#else
+    #error "lxSwappableAtomic.h : no atomic support for this compiler."
+#endif
+};
+
+};
+
+#endif
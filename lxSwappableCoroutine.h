@@ -0,0 +1,103 @@
+/*
+// ====================================================================================
+//  C++20 coroutine support for the hot-swappable smart pointer library.
+//
+//    - co_await mgr.swapAsync(oldObj, newObj) queues the swap and suspends the coroutine.
+//    - The coroutine is resumed once the swap is done, inside SwappableManager::drainSwaps().
+//    - No dependency on an executor : by default the coroutine is resumed inline by the
+//      thread draining the swaps, a resume function can be given to post it somewhere else.
+//
+//  Usage :
+//    Task reload(SwappableManager* mgr, MyClass* oldObj, MyClass* newObj) {
+//        co_await mgr->swapAsync(oldObj, newObj);
+//        // All the hotswap_ptr on oldObj now point to newObj.
+//    }
+//
+//    // Somewhere in the frame, from the thread owning the manager :
+//    mgr->drainSwaps();
+//
+//  Note :
+//  - Queue and drain follow the manager rule : same thread, or protected by the user.
+//  - No allocation, the swap request lives inside the awaitable, inside the coroutine frame.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_COROUTINE_H
+#define LX_SWAPPABLE_COROUTINE_H
+
+#include "lxSwappablePointer.h"
+#include <coroutine>
+
+namespace lx {
+
+/*  ====================================================================================
+    Awaitable returned by SwappableManager::swapAsync
+    ==================================================================================== */
+class SwapAwaitable {
+public:
+    /* Function used to resume the coroutine, ie post it to a job system.       */
+    typedef void (*ResumeFunc)(void* context, std::coroutine_handle<> coroutine);
+
+    SwapAwaitable(SwappableManager* mgr, Swappable* oldInstance, Swappable* newInstance)
+    :m_mgr          (mgr)
+    ,m_resume       (0)
+    ,m_resumeContext(0)
+    {
+        m_request.m_oldInstance = oldInstance;
+        m_request.m_newInstance = newInstance;
+        m_request.m_onDone      = &SwapAwaitable::onDone;
+        m_request.m_retireOld   = 0;
+        m_request.m_userData    = 0;                     // Set once suspended, the awaitable may be copied before.
+        m_request.m_next        = 0;
+    }
+
+    /* Resume through the given function instead of inline in drainSwaps()      */
+    SwapAwaitable& via(ResumeFunc resume, void* context) {
+        m_resume        = resume;
+        m_resumeContext = context;
+        return *this;
+    }
+
+    /* Same rule as hotSwapTo : nothing to do with a NULL object.               */
+    bool await_ready    () const {
+        return (m_request.m_oldInstance == 0) || (m_request.m_newInstance == 0);
+    }
+
+    void await_suspend  (std::coroutine_handle<> coroutine) {
+        // Inside the coroutine frame from now on : the address is stable until resumed.
+        m_coroutine             = coroutine;
+        m_request.m_userData    = this;
+        m_mgr->queueSwap(&m_request);
+    }
+
+    void await_resume   () const { }
+
+private:
+    static void onDone  (SwappableManager::SwapRequest* request) {
+        // Awaitable may be destroyed as soon as the coroutine runs : copy first.
+        SwapAwaitable*          self      = (SwapAwaitable*)request->m_userData;
+        std::coroutine_handle<> coroutine = self->m_coroutine;
+        if (self->m_resume) {
+            self->m_resume(self->m_resumeContext, coroutine);
+        } else {
+            coroutine.resume();
+        }
+    }
+
+    SwappableManager::SwapRequest   m_request;
+    SwappableManager*               m_mgr;
+    std::coroutine_handle<>         m_coroutine;
+    ResumeFunc                      m_resume;
+    void*                           m_resumeContext;
+};
+
+template<class T>
+SwapAwaitable SwappableManager::swapAsync(T* oldObj, T* newObj) {
+    return SwapAwaitable(this,
+                         oldObj ? &oldObj->_trackMe : 0,
+                         newObj ? &newObj->_trackMe : 0);
+}
+
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include "lxSwappableExternal.h"
+
+namespace lx {
+
+/*static*/
+SwappableExternal* SwappableExternal::s_table = 0;
+
+/*static*/
+size_t SwappableExternal::getCapacity(size_t maxObjects) {
+    // Always keep an empty entry : a search stops on it.
+    size_t needed   = maxObjects + (maxObjects >> 3) + 1;
+    size_t capacity = 2;
+    while (capacity < needed) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+/*static*/
+size_t SwappableExternal::getAllocSize(size_t maxObjects) {
+    return getCapacity(maxObjects) * sizeof(ENTRY);
+}
+
+bool SwappableExternal::init(void* alignPtr_buffer, size_t bufferSize, size_t maxObjects, SwappableManager* mgr) {
+    if (bufferSize < getAllocSize(maxObjects)) {
+        return false;
+    }
+
+    size_t capacity     = getCapacity(maxObjects);
+    m_entries           = (ENTRY*)alignPtr_buffer;
+    m_mgr               = mgr;
+    m_mask              = capacity - 1;
+    m_count             = 0;
+    m_maxObjects        = maxObjects;
+    m_shift             = 64;
+    while (capacity > 1) {
+        capacity >>= 1;
+        m_shift--;
+    }
+
+    for (size_t n=0; n <= m_mask; n++) {
+        m_entries[n].m_key = 0;
+    }
+    s_table             = this;
+    return true;
+}
+
+void SwappableExternal::release() {
+    if (s_table == this) {
+        s_table = 0;
+    }
+}
+
+bool SwappableExternal::add(const void* object) {
+    if (m_count == m_maxObjects) {
+        return false;
+    }
+
+    size_t pos = home(object);
+    while (m_entries[pos].m_key) {
+        if (m_entries[pos].m_key == object) {
+            return false;
+        }
+        pos = (pos + 1) & m_mask;
+    }
+
+    SwappableIndex handle = m_mgr->allocateSwappable(object);
+    if (handle == SwappableManager::NULL_IDX) {
+        return false;
+    }
+    m_entries[pos].m_key    = object;
+    m_entries[pos].m_handle = handle;
+    m_count++;
+    return true;
+}
+
+bool SwappableExternal::remove(const void* object) {
+    size_t pos = home(object);
+    while (m_entries[pos].m_key != object) {
+        if (m_entries[pos].m_key == 0) {
+            return false;
+        }
+        pos = (pos + 1) & m_mask;
+    }
+    m_mgr->freeSwappable(m_entries[pos].m_handle);
+    m_count--;
+
+    //
+    // Shift back the following entries of the cluster which can reach the hole,
+    // so searches never need to skip removed entries.
+    //
+    size_t hole = pos;
+    for (size_t next = (pos + 1) & m_mask; m_entries[next].m_key; next = (next + 1) & m_mask) {
+        size_t start = home(m_entries[next].m_key);
+        if (((next - start) & m_mask) >= ((next - hole) & m_mask)) {
+            m_entries[hole] = m_entries[next];
+            hole            = next;
+        }
+    }
+    m_entries[hole].m_key = 0;
+    return true;
+}
+
+bool SwappableExternal::replace(const void* oldObject, const void* newObject) {
+    SwappableIndex handleOld;
+    SwappableIndex handleNew;
+    if (find(oldObject, handleOld) && find(newObject, handleNew)) {
+        m_mgr->replaceSlot(handleOld, handleNew);
+        return true;
+    }
+    return false;
+}
+
+} // End namespace lx
@@ -0,0 +1,228 @@
+/*
+// ====================================================================================
+//  Non intrusive registration, for classes which can not use MAKESWAPPABLE
+//  (ie types from external libraries).
+//
+//    - Objects are registered by address in an open addressing hash table,
+//      mapping to their entry in the manager.
+//    - hotswap_ptr< swappable_extern<T> > references such objects, and work as
+//      usual hotswap_ptr : no overhead when using the pointer, the table is only
+//      searched when a reference is assigned, released or swapped.
+//    - Linear probing on a power of two table, 16 byte entries : a lookup usually
+//      reads a single cache line. Removal shifts entries back, no tombstone, so
+//      lookups do not degrade after many add/remove.
+//    - User has to provide memory, no allocation is performed by the system.
+//
+//  Usage :
+//    SwappableExternal table;
+//    table.init(buffer, SwappableExternal::getAllocSize(1024), 1024, mgr);
+//    table.add(texture);                                   // texture is a ThirdParty*
+//
+//    hotswap_ptr< swappable_extern<ThirdParty> > ref = texture;
+//    table.add(newTexture);
+//    ref.hotSwapTo(newTexture);                            // All references move.
+//    table.remove(texture);
+//
+//  Note :
+//  - One table serves all the external references, init() installs it.
+//  - Same rule as a swappable object : an object must not be removed while referenced.
+//  - Objects are registered in the manager : it must have free entries for them.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_EXTERNAL_H
+#define LX_SWAPPABLE_EXTERNAL_H
+
+#include "lxSwappablePointer.h"
+
+namespace lx {
+
+/*  ====================================================================================
+    Address to manager entry table.
+    ==================================================================================== */
+class SwappableExternal {
+    template<class U> friend class hotswap_ptr;
+public:
+    /* Function for the client to know how much memory is needed in advance before
+       doing calling the init(...) function */
+    static
+    size_t  getAllocSize    (size_t maxObjects);
+
+    /* Setup the table for maxObjects registered objects, tracked in the manager.
+       Return true if successful, false if memory was not big enough.            */
+    bool init            (void* alignPtr_buffer, size_t bufferSize, size_t maxObjects, SwappableManager* mgr);
+
+    /* Uninstall the table. All objects must have been removed.                 */
+    void release         ();
+
+    /* Register an object. Return false if already registered, or if the table
+       or the manager is full.                                                   */
+    bool add             (const void* object);
+
+    /* Unregister an object. Return false if not registered.                    */
+    bool remove          (const void* object);
+
+    /* Entry of the object inside the manager, false if not registered.         */
+    inline
+    bool find            (const void* object, SwappableIndex& handle) const {
+        size_t pos = home(object);
+        for (;;) {
+            const ENTRY& entry = m_entries[pos];
+            if (entry.m_key == object) {
+                handle = entry.m_handle;
+                return true;
+            }
+            if (entry.m_key == 0) {
+                return false;
+            }
+            pos = (pos + 1) & m_mask;
+        }
+    }
+
+    /* Move all references of the old object to the new one.
+       Return false if one of them is not registered.                           */
+    bool replace         (const void* oldObject, const void* newObject);
+
+    SwappableManager* getManager () const { return m_mgr;      }
+    size_t            getCount   () const { return m_count;    }
+    size_t            getCapacity() const { return m_mask + 1; }
+
+private:
+    struct ENTRY {
+        const void*     m_key;                          // Object address, NULL if empty.
+        SwappableIndex  m_handle;                       // Entry inside the manager.
+    };
+
+    /* Table size for a number of objects : load factor stays below 8/9.       */
+    static
+    size_t  getCapacity     (size_t maxObjects);
+
+    /* Fibonacci hashing : objects are at least 8 byte aligned, low bits carry nothing
+       and the multiply spreads consecutive allocations over the whole table.   */
+    inline
+    size_t  home            (const void* object) const {
+        unsigned long long key = (unsigned long long)(size_t)object >> 3;
+        return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> m_shift);
+    }
+
+    static SwappableExternal*   s_table;                // Table used by the external references.
+
+    ENTRY*              m_entries;
+    SwappableManager*   m_mgr;
+    size_t              m_mask;                         // Capacity - 1.
+    size_t              m_count;
+    size_t              m_maxObjects;
+    unsigned int        m_shift;                        // 64 - log2(capacity).
+};
+
+/* Tag to reference an object registered in SwappableExternal                  */
+template < typename T >
+struct swappable_extern {
+};
+
+/*  ====================================================================================
+        Smart pointer on a registered external object, no overhead when using the pointer.
+        Assigning an object which is not registered gives a NULL reference.
+    ====================================================================================*/
+template < typename T >
+class hotswap_ptr< swappable_extern<T> > {
+private:
+    SwappableManager::SwappableInstance instance;
+
+    // Force object to be a member or alloc on stack only.
+    void *operator   new      ( size_t );
+    void operator    delete   ( void*  );
+    void *operator   new[]    ( size_t );
+    void operator    delete[] ( void*  );
+
+    void update(const void* obj) {
+        if (obj == instance.ptr) {
+            return;
+        }
+
+        SwappableExternal* table = SwappableExternal::s_table;
+        SwappableManager*  mgr   = table->m_mgr;
+        SwappableIndex     handle;
+        if (instance.ptr && table->find(instance.ptr, handle)) {
+            mgr->removeReference(&instance, handle);
+        }
+        instance.ptr = 0;
+
+        if (obj && table->find(obj, handle)) {
+            LX_SWAPPABLE_PERF_SCOPE(mgr, OP_ATTACH_REFERENCE);
+            instance.ptr = obj;
+            mgr->addListStart(&instance, handle);
+        }
+    }
+public:
+    hotswap_ptr()
+    {
+    }
+
+    hotswap_ptr(T* pValue)
+    {
+        update(pValue);
+    }
+
+    hotswap_ptr(const hotswap_ptr< swappable_extern<T> >& sp)
+    {
+        update(sp.instance.ptr);
+    }
+
+    ~hotswap_ptr()
+    {
+        update(0);
+    }
+
+    T& operator* () const
+    {
+        return *(T*)instance.ptr;
+    }
+
+    T* operator-> () const
+    {
+        return (T*)instance.ptr;
+    }
+
+    T* get() const
+    {
+        return (T*)instance.ptr;
+    }
+
+    hotswap_ptr< swappable_extern<T> >& operator = (const hotswap_ptr< swappable_extern<T> >& sp)
+    {
+        if (this != &sp) {
+            update(sp.instance.ptr);
+        }
+        return *this;
+    }
+
+    hotswap_ptr< swappable_extern<T> >& operator = (T* obj)
+    {
+        update(obj);
+        return *this;
+    }
+
+    // Support for NULL, it can't be helped.
+    hotswap_ptr< swappable_extern<T> >& operator = (int obj)
+    {
+        if (obj == 0) {
+            update(0);
+        }
+        return *this;
+    }
+
+    /* Hotswap from any place all user of the same pointer.
+       Return false if current object is NULL, or new object NULL or not registered. */
+    bool hotSwapTo(T* obj) {
+        if (this->instance.ptr && obj) {
+            return SwappableExternal::s_table->replace(instance.ptr, obj);
+        } else {
+            return false;
+        }
+    }
+};
+
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+// ====================================================================================
+//  C++11 hot-swappable functions for the hot-swappable smart pointer library.
+//
+//    - SwappableFunction<R(Args...)> is a registered implementation : a function
+//      pointer tracked by the manager like any MAKESWAPPABLE object.
+//    - hotswap_fn<R(Args...)> is a holder : swapping the implementation retargets
+//      all the holders at once, through the usual reference lists.
+//    - A call is a load of the implementation and a single indirect call, no
+//      std::function, no allocation, no type erasure.
+//
+//  Usage :
+//    int damageV1(int hp);
+//    int damageV2(int hp);
+//
+//    SwappableFunction<int(int)> damage(&damageV1, mgr);
+//    hotswap_fn<int(int)>        onHit(&damage);           // Stored in many places.
+//    onHit(10);                                            // Calls damageV1.
+//
+//    SwappableFunction<int(int)> reloaded(&damageV2, mgr);
+//    onHit.hotSwapTo(&reloaded);                           // Every holder calls damageV2.
+//
+//  Note :
+//  - Implementations are usually static objects of the module providing the
+//    functions : swapping to the new module objects retargets the whole program
+//    before the old module is unloaded.
+//  - Calling an empty holder is undefined, as calling a NULL function pointer.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_FUNCTION_H
+#define LX_SWAPPABLE_FUNCTION_H
+
+#include "lxSwappablePointer.h"
+#include <utility>
+
+namespace lx {
+
+template < typename Signature > class SwappableFunction;
+template < typename Signature > class hotswap_fn;
+
+/*  ====================================================================================
+        Registered implementation of a function signature.
+    ==================================================================================== */
+template < typename R, typename... Args >
+class SwappableFunction<R(Args...)> {
+    template<class U> friend class hotswap_fn;
+public:
+    typedef R (*Func)(Args...);
+private:
+    // First member : a holder reaches it from the owner pointer without adjustment.
+    Func                m_func;
+
+    MAKESWAPPABLE(SwappableFunction)
+
+public:
+    SwappableFunction(Func func, SwappableManager* mgr)
+    :m_func     (func)
+    ,_trackMe   (this, mgr)
+    {
+    }
+
+    Func get() const { return m_func; }
+};
+
+/*  ====================================================================================
+        Holder calling the current implementation.
+    ==================================================================================== */
+template < typename R, typename... Args >
+class hotswap_fn<R(Args...)> {
+public:
+    typedef SwappableFunction<R(Args...)> Impl;
+private:
+    hotswap_ptr<Impl>   m_ref;
+public:
+    hotswap_fn()
+    {
+    }
+
+    hotswap_fn(Impl* impl)
+    :m_ref(impl)
+    {
+    }
+
+    hotswap_fn(const hotswap_fn& fn)
+    :m_ref(fn.m_ref)
+    {
+    }
+
+    R operator() (Args... args) const
+    {
+        return ((const Impl*)m_ref.instance.ptr)->m_func(std::forward<Args>(args)...);
+    }
+
+    /* Current implementation, NULL if empty                                     */
+    Impl* get() const
+    {
+        return (Impl*)m_ref.instance.ptr;
+    }
+
+    hotswap_fn& operator = (const hotswap_fn& fn)
+    {
+        m_ref = fn.m_ref;
+        return *this;
+    }
+
+    hotswap_fn& operator = (Impl* impl)
+    {
+        m_ref = impl;
+        return *this;
+    }
+
+    // Support for NULL, it can't be helped.
+    hotswap_fn& operator = (int impl)
+    {
+        m_ref = impl;
+        return *this;
+    }
+
+    /* Retarget all the holders of the current implementation.
+       Return false if empty or if impl is NULL.                                 */
+    bool hotSwapTo(Impl* impl)
+    {
+        return m_ref.hotSwapTo(impl);
+    }
+};
+
+};
+
+#endif
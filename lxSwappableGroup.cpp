@@ -0,0 +1,142 @@
+#include "lxSwappableGroup.h"
+
+namespace lx {
+
+size_t SwappableReferenceSet::detach(const void* keep, const void* type) {
+    // Key the references to unlink, others sort first with a NULL manager.
+    size_t linked = 0;
+    for (size_t n=0; n < m_count; n++) {
+        ENTRY& entry        = m_entries[n];
+        const void* owner   = entry.m_ref->ptr;
+        entry.m_mgr         = 0;
+        entry.m_handle      = 0;
+        if (owner && (owner != keep) && (!type || (entry.m_type == type))) {
+            Swappable& target   = entry.m_tracker(owner);
+            entry.m_mgr         = target.getManager();
+            entry.m_handle      = target.getSlot();
+            linked++;
+        }
+    }
+    if (linked == 0) {
+        return 0;
+    }
+
+    sortEntries();
+
+    //
+    // Entries of the manager are visited in increasing order, one run per target :
+    // the references are unlinked around a local head, written back once.
+    //
+    typedef SwappableManager::SwappableInstance Instance;
+    size_t n = m_count - linked;
+    while (n < m_count) {
+        SwappableManager*   mgr    = m_entries[n].m_mgr;
+        SwappableIndex      handle = m_entries[n].m_handle;
+        Instance*           head   = mgr->m_arrayList[handle].m_linkList;
+        for (; (n < m_count) && (m_entries[n].m_mgr == mgr) && (m_entries[n].m_handle == handle); n++) {
+            Instance* wrapper = m_entries[n].m_ref;
+            Instance* prev    = SwappableManager::getPrevLink(wrapper);
+            Instance* next    = wrapper->next;
+            if (prev) {
+                prev->next = next;
+            } else {
+                head = next;
+            }
+            if (next) {
+                SwappableManager::setPrevLink(next, prev);
+            }
+            SwappableAtomic::storeRelease(&wrapper->ptr, (const void*)0);
+        }
+        mgr->m_arrayList[handle].m_linkList = head;
+    }
+    return linked;
+}
+
+void SwappableReferenceSet::sortEntries() {
+    // Heap sort : in place, no allocation, batches can be large.
+    ENTRY* e = m_entries;
+    size_t count = m_count;
+    for (size_t start = count / 2; start-- > 0; ) {
+        for (size_t root = start; (root * 2 + 1) < count; ) {
+            size_t child = root * 2 + 1;
+            if (((child + 1) < count) && lessEntry(e[child], e[child + 1])) {
+                child++;
+            }
+            if (!lessEntry(e[root], e[child])) {
+                break;
+            }
+            ENTRY tmp = e[root]; e[root] = e[child]; e[child] = tmp;
+            root = child;
+        }
+    }
+    for (size_t end = count; end-- > 1; ) {
+        ENTRY tmp = e[0]; e[0] = e[end]; e[end] = tmp;
+        for (size_t root = 0; (root * 2 + 1) < end; ) {
+            size_t child = root * 2 + 1;
+            if (((child + 1) < end) && lessEntry(e[child], e[child + 1])) {
+                child++;
+            }
+            if (!lessEntry(e[root], e[child])) {
+                break;
+            }
+            tmp = e[root]; e[root] = e[child]; e[child] = tmp;
+            root = child;
+        }
+    }
+}
+
+int SwappableReferenceGroup::unlinkAll() {
+    int unlinked = (int)detach(0, 0);
+    m_count = 0;
+    return unlinked;
+}
+
+/*static*/
+size_t SwappableReferenceBatch::getAllocSize(size_t maxRefs) {
+    return maxRefs * sizeof(ENTRY);
+}
+
+bool SwappableReferenceBatch::init(void* alignPtr_buffer, size_t bufferSize, size_t maxRefs) {
+    if (bufferSize < getAllocSize(maxRefs)) {
+        return false;
+    }
+
+    m_entries           = (ENTRY*)alignPtr_buffer;
+    m_maxRefs           = maxRefs;
+    m_count             = 0;
+    return true;
+}
+
+size_t SwappableReferenceBatch::assignOwner(const void* owner, Swappable* target, const void* type) {
+    detach(owner, type);
+
+    //
+    // Chain the references locally, the list of the target is only touched
+    // once to splice the chain at its head.
+    //
+    SwappableManager::SwappableInstance* first = 0;
+    SwappableManager::SwappableInstance* last  = 0;
+    size_t changed = 0;
+    for (size_t n=0; n < m_count; n++) {
+        SwappableManager::SwappableInstance* wrapper = m_entries[n].m_ref;
+        if ((m_entries[n].m_type != type) || (wrapper->ptr == owner)) {
+            continue;
+        }
+        SwappableManager::setPrevLink(wrapper, last);
+        if (last) {
+            last->next = wrapper;
+        } else {
+            first = wrapper;
+        }
+        last = wrapper;
+        SwappableAtomic::storeRelease(&wrapper->ptr, owner);
+        changed++;
+    }
+
+    if (first) {
+        target->getManager()->spliceListStart(first, last, target->getSlot());
+    }
+    return changed;
+}
+
+} // End namespace lx
@@ -0,0 +1,195 @@
+/*
+// ====================================================================================
+//  Batched reference operations.
+//
+//    - Reference groups : the hotswap_ptr members of an object are registered once,
+//      on destruction the group unlinks them together.
+//    - Reference batches : many references are pointed at the same object at once
+//      (ie a default material at load time). They are chained locally and the chain
+//      is spliced in the target list with a single head update.
+//    - Detach is batched for both : targets are sorted by manager and handle first,
+//      so the manager entries are visited in order instead of jumping between
+//      unrelated lists for each reference, and the list head of each target is
+//      written once for all its references.
+//    - No allocation, storage is inside the group or given by the user.
+//
+//  Usage :
+//    class Entity {
+//    public:
+//        hotswap_ptr<Mesh>       mesh;
+//        hotswap_ptr<Material>   material;
+//        ...
+//        hotswap_group<20>       refs;               // Declared after the members : destroyed first.
+//
+//        Entity() {
+//            refs.add(mesh);
+//            refs.add(material);
+//            ...
+//        }
+//    };
+//
+//    SwappableReferenceBatch batch;
+//    batch.init(buffer, SwappableReferenceBatch::getAllocSize(4096), 4096);
+//    for (int n=0; n < count; n++) {
+//        batch.add(meshes[n].material);
+//    }
+//    batch.assign(defaultMaterial);
+//
+//  Note :
+//  - Only plain hotswap_ptr, owning references have their own life cycle.
+//  - Same thread rule as any reference change.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_GROUP_H
+#define LX_SWAPPABLE_GROUP_H
+
+#include "lxSwappablePointer.h"
+
+namespace lx {
+
+/*  ====================================================================================
+    Registered references, storage is given by the derived class.
+    ==================================================================================== */
+class SwappableReferenceSet {
+public:
+    /* Register a reference. Return false if full.                              */
+    template<class T>
+    bool add             (hotswap_ptr<T>& ref) {
+        if (m_count == m_maxRefs) {
+            return false;
+        }
+        ENTRY& entry    = m_entries[m_count++];
+        entry.m_ref     = &ref.instance;
+        entry.m_tracker = &SwappableCast<T>::tracker;
+        entry.m_type    = TypeTag<T>::get();
+        return true;
+    }
+
+    /* Forget the registered references, they are not modified.                 */
+    void clear           () { m_count = 0; }
+
+    /* Number of registered references                                           */
+    size_t getCount      () const { return m_count; }
+
+protected:
+    typedef Swappable& (*TrackerFunc)(const void* owner);
+
+    /* Identity of the reference type T : the address of a variable per T.
+       Function addresses are not used, identical code folding merges them.     */
+    template<class T>
+    struct TypeTag {
+        static const void* get() { return &s_tag; }
+        static char s_tag;
+    };
+
+    struct ENTRY {
+        SwappableManager::SwappableInstance*    m_ref;
+        TrackerFunc                             m_tracker;
+        const void*                             m_type;         // TypeTag<T>::get()
+        // Filled by detach.
+        SwappableManager*                       m_mgr;          // NULL if not linked.
+        SwappableIndex                          m_handle;
+    };
+
+    SwappableReferenceSet()
+    :m_entries  (0)
+    ,m_maxRefs  (0)
+    ,m_count    (0)
+    {
+    }
+
+    /* Unlink the references of type tag (NULL : all) not pointing to keep, sorted
+       by target. They are left NULL. Return the number of references unlinked.  */
+    size_t detach        (const void* keep, const void* type);
+
+    ENTRY*              m_entries;
+    size_t              m_maxRefs;
+    size_t              m_count;
+
+private:
+    // Registered addresses belong to the user : no copy.
+    SwappableReferenceSet                   (const SwappableReferenceSet&);
+    SwappableReferenceSet& operator =       (const SwappableReferenceSet&);
+
+    static inline
+    bool lessEntry       (const ENTRY& a, const ENTRY& b) {
+        return ((size_t)a.m_mgr < (size_t)b.m_mgr) || ((a.m_mgr == b.m_mgr) && (a.m_handle < b.m_handle));
+    }
+
+    void sortEntries     ();
+};
+
+/*  ====================================================================================
+    Group : references of an object, unlinked together when the group dies.
+    ==================================================================================== */
+class SwappableReferenceGroup : public SwappableReferenceSet {
+public:
+    /* Unlink all the registered references, they become NULL and the group is
+       empty. Return the number of references unlinked.                          */
+    int  unlinkAll       ();
+
+protected:
+    SwappableReferenceGroup(ENTRY* entries, int maxRefs)
+    {
+        m_entries   = entries;
+        m_maxRefs   = maxRefs;
+    }
+
+    ~SwappableReferenceGroup() {
+        unlinkAll();
+    }
+};
+
+/*  ====================================================================================
+    Group of at most N references, to put inside the object owning them.
+    ==================================================================================== */
+template < int N >
+class hotswap_group : public SwappableReferenceGroup {
+public:
+    hotswap_group()
+    :SwappableReferenceGroup(m_storage, N)
+    {
+    }
+
+private:
+    ENTRY               m_storage[N];
+};
+
+/*  ====================================================================================
+    Batch : many references retargeted to the same object.
+    ==================================================================================== */
+class SwappableReferenceBatch : public SwappableReferenceSet {
+public:
+    /* Function for the client to know how much memory is needed in advance before
+       doing calling the init(...) function */
+    static
+    size_t  getAllocSize    (size_t maxRefs);
+
+    /* Setup buffer used for the registered references.
+       Return true if successful, false if memory was not big enough.            */
+    bool init            (void* alignPtr_buffer, size_t bufferSize, size_t maxRefs);
+
+    /* Point all the registered hotswap_ptr<T> at obj (NULL to clear them) : old
+       targets are detached sorted by handle, then the references are chained and
+       spliced in the list of obj with one head update.
+       References of another type are left untouched. The batch stays registered.
+       Return the number of references changed.                                  */
+    template<class T>
+    size_t assign        (T* obj) {
+        if (obj) {
+            return assignOwner(SwappableCast<T>::toOwner(obj), &obj->_trackMe, TypeTag<T>::get());
+        }
+        return detach(0, TypeTag<T>::get());
+    }
+
+private:
+    size_t assignOwner   (const void* owner, Swappable* target, const void* type);
+};
+
+template<class T>
+char SwappableReferenceSet::TypeTag<T>::s_tag = 0;
+
+};
+
+#endif
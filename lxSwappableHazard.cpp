@@ -0,0 +1,149 @@
+#include "lxSwappableHazard.h"
+
+namespace lx {
+
+/*static*/
+int SwappableHazard::getAllocSize(int hazardCount, int retireCount) {
+    unsigned int bufferSizeSlots            = hazardCount * sizeof(SLOT       );
+    unsigned int bufferSizeRetired          = retireCount * sizeof(RETIRED    );
+    unsigned int bufferSizeScratch          = hazardCount * sizeof(const void*);
+    return (int)(bufferSizeSlots + bufferSizeRetired + bufferSizeScratch);
+}
+
+bool SwappableHazard::init(void* alignPtr_buffer, int bufferSize, int hazardCount, int retireCount) {
+    if ((retireCount <= hazardCount) || (bufferSize < getAllocSize(hazardCount, retireCount))) {
+        return false;
+    }
+
+    unsigned char* ptr  = (unsigned char*)alignPtr_buffer;
+    m_slots             = (SLOT*)ptr;
+    m_retired           = (RETIRED*)&m_slots[hazardCount];
+    m_scratch           = (const void**)&m_retired[retireCount];
+    m_hazardCount       = hazardCount;
+    m_retireCount       = retireCount;
+    m_retiredUsed       = 0;
+    m_doomed            = 0;
+    m_scanning          = false;
+
+    for (int n=0; n < hazardCount; n++) {
+        m_slots[n].m_ptr  = 0;
+        m_slots[n].m_used = 0;
+    }
+    return true;
+}
+
+void SwappableHazard::release() {
+    // Destructors may retire other objects : go on until nothing is left.
+    while (m_retiredUsed > 0) {
+        m_doomed = m_retiredUsed;
+        while (m_doomed > 0) {
+            destroyOne();
+        }
+    }
+}
+
+int SwappableHazard::acquireSlot() {
+    for (int n=0; n < m_hazardCount; n++) {
+        if ((SwappableAtomic::loadRelaxed(&m_slots[n].m_used) == 0)
+         && SwappableAtomic::compareExchange(&m_slots[n].m_used, 0U, 1U)) {
+            return n;
+        }
+    }
+    return -1;
+}
+
+void SwappableHazard::releaseSlot(int slot) {
+    clear(slot);
+    SwappableAtomic::storeRelease(&m_slots[slot].m_used, 0U);
+}
+
+void SwappableHazard::retire(void* object, SwappableDestroyFunc destroy) {
+    if (m_retiredUsed == m_retireCount) {
+        // More retired objects than slots : at least one is not protected.
+        scan();
+        while (m_retiredUsed == m_retireCount) {
+            // Refilled by destructors, or called from one during scan which only
+            // collected : free entries here.
+            if (m_doomed == 0) {
+                collect();
+            }
+            destroyOne();
+        }
+    }
+    m_retired[m_retiredUsed].m_object  = object;
+    m_retired[m_retiredUsed].m_destroy = destroy;
+    m_retiredUsed++;
+}
+
+int SwappableHazard::scan() {
+    collect();
+    if (m_scanning) {
+        // Called from a destructor : the running scan destroys what was found.
+        return 0;
+    }
+
+    m_scanning    = true;
+    int destroyed = 0;
+    while (m_doomed > 0) {
+        destroyOne();
+        destroyed++;
+    }
+    m_scanning    = false;
+    return destroyed;
+}
+
+void SwappableHazard::collect() {
+    // Objects are not reachable anymore from references : see all hazards published before.
+    SwappableAtomic::fence();
+
+    //
+    // Snapshot and sort the hazards.
+    //
+    int hazardUsed = 0;
+    for (int n=0; n < m_hazardCount; n++) {
+        const void* ptr = SwappableAtomic::loadAcquire(&m_slots[n].m_ptr);
+        if (ptr) {
+            // Insertion sort, slot count is small.
+            int pos = hazardUsed++;
+            while ((pos > 0) && (m_scratch[pos-1] > ptr)) {
+                m_scratch[pos] = m_scratch[pos-1];
+                pos--;
+            }
+            m_scratch[pos] = ptr;
+        }
+    }
+
+    //
+    // Move the objects which are not protected in front of the others.
+    //
+    for (int n=m_doomed; n < m_retiredUsed; n++) {
+        const void* object = m_retired[n].m_object;
+        int low  = 0;
+        int high = hazardUsed;
+        while (low < high) {
+            int mid = (low + high) >> 1;
+            if (m_scratch[mid] < object) { low = mid + 1; } else { high = mid; }
+        }
+
+        if ((low == hazardUsed) || (m_scratch[low] != object)) {
+            RETIRED doomed      = m_retired[n];
+            m_retired[n]        = m_retired[m_doomed];
+            m_retired[m_doomed] = doomed;
+            m_doomed++;
+        }
+    }
+}
+
+void SwappableHazard::destroyOne() {
+    // Taken out of the list first : the destructor may retire other objects.
+    RETIRED retired             = m_retired[--m_doomed];
+    m_retired[m_doomed]         = m_retired[--m_retiredUsed];
+    retired.m_destroy(retired.m_object);
+}
+
+/*static*/
+void SwappableHazard::retireHandler(void* context, void* object, SwappableDestroyFunc destroy) {
+    ((SwappableHazard*)context)->retire(object, destroy);
+}
+
+} // End namespace lx
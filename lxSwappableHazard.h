@@ -0,0 +1,157 @@
+/*
+// ====================================================================================
+//  Hazard pointer protection for objects used across threads.
+//
+//    - A thread holding a dereferenced object for a long time (ie streaming job)
+//      publishes it in a hazard slot. Swapped-out objects are destroyed as soon as
+//      no slot references them, without waiting for every thread to reach a common point.
+//    - Plug into the manager retire path : objects retired by the manager
+//      (SwappableManager::retire, SwapRequest::m_retireOld) go through the domain.
+//    - User has to provide memory, no allocation is performed by the system.
+//
+//  Usage :
+//    SwappableHazard hazard;
+//    hazard.init(buffer, SwappableHazard::getAllocSize(16, 64), 16, 64);
+//    hazard.attach(mgr);
+//
+//    // Reader thread
+//    int slot   = hazard.acquireSlot();
+//    MyClass* p = hazard.protect(slot, owner.myClass);  // p stays valid until clear/release.
+//    ...
+//    hazard.releaseSlot(slot);
+//
+//    // Manager thread, from time to time (retire also does it when the list is full)
+//    hazard.scan();
+//
+//  Note :
+//  - retire/scan must be called from the thread owning the manager.
+//  - Retire list must be bigger than the number of slots : a full list always frees something.
+//  - Destructors may retire other objects : entries leave the list before being destroyed.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_HAZARD_H
+#define LX_SWAPPABLE_HAZARD_H
+
+#include "lxSwappablePointer.h"
+
+namespace lx {
+
+class SwappableHazard {
+public:
+    /* Function for the client to know how much memory is needed in advance before
+       doing calling the init(...) function */
+    static
+    int     getAllocSize    (int hazardCount, int retireCount);
+
+    /* Setup buffer used for hazard slots and retired objects.
+       Return false if memory was not big enough or retireCount <= hazardCount. */
+    bool init            (void* alignPtr_buffer, int bufferSize, int hazardCount, int retireCount);
+
+    /* Destroy all the retired objects. No reader must still be running.        */
+    void release         ();
+
+    /* Install the domain as the retire handler of the manager                  */
+    void attach          (SwappableManager* mgr) {
+        mgr->setRetireHandler(&SwappableHazard::retireHandler, this);
+    }
+
+    /* Reserve a hazard slot for the calling thread, -1 if none available.
+       Can be called from any thread.                                            */
+    int  acquireSlot     ();
+
+    /* Clear and give back the slot                                              */
+    void releaseSlot     (int slot);
+
+    /* Load the pointer of the reference and protect it in the slot.
+       Object stays alive until the slot is cleared, even if swapped out.       */
+    template<class T>
+    T*   protect         (int slot, const hotswap_ptr<T>& ref) {
+        const void* const* source = &ref.instance.ptr;
+        const void* ptr = SwappableAtomic::loadAcquire(source);
+        for (;;) {
+            publish(slot, ptr);
+            const void* again = SwappableAtomic::loadAcquire(source);
+            if (again == ptr) {
+                return SwappableCast<T>::fromOwner(ptr);
+            }
+            ptr = again;
+        }
+    }
+
+    template<class T>
+    T*   protect         (int slot, const hotswap_atomic_ptr<T>& ref) {
+        return protect(slot, ref.m_ref);
+    }
+
+    template<class T>
+    T*   protect         (int slot, const hotswap_handle<T>& ref) {
+        T* ptr = ref.get();
+        for (;;) {
+            // Retired objects are identified by their owner pointer.
+            publish(slot, SwappableCast<T>::toOwner(ptr));
+            T* again = ref.get();
+            if (again == ptr) {
+                return ptr;
+            }
+            ptr = again;
+        }
+    }
+
+    /* Stop protecting the object in the slot                                    */
+    void clear           (int slot) {
+        SwappableAtomic::storeRelease(&m_slots[slot].m_ptr, (const void*)0);
+    }
+
+    /* Destroy the object once no slot references it.                           */
+    void retire          (void* object, SwappableDestroyFunc destroy);
+
+    /* Destroy the retired objects which are not protected anymore.
+       Return the number of objects destroyed. Called again from a destructor,
+       it only marks the objects found : the running scan destroys them.         */
+    int  scan            ();
+
+private:
+    static const int    CACHE_LINE  = 64;
+
+    /* One slot per cache line, reader threads do not share lines.              */
+    struct SLOT {
+        const void*     m_ptr;                          // Protected object, NULL if none.
+        unsigned int    m_used;                         // Slot owned by a thread.
+        unsigned char   m_pad[CACHE_LINE - sizeof(void*) - sizeof(unsigned int)];
+    };
+
+    struct RETIRED {
+        void*                   m_object;
+        SwappableDestroyFunc    m_destroy;
+    };
+
+    inline
+    void publish         (int slot, const void* ptr) {
+        SwappableAtomic::storeRelaxed(&m_slots[slot].m_ptr, ptr);
+        // Make the hazard visible before the reference is read again.
+        SwappableAtomic::fence();
+    }
+
+    static
+    void retireHandler   (void* context, void* object, SwappableDestroyFunc destroy);
+
+    /* Move the retired objects not protected by any slot in front of the list  */
+    void collect         ();
+
+    /* Take the last object found by collect out of the list and destroy it     */
+    void destroyOne      ();
+
+    SLOT*               m_slots;                        // Hazard slots.
+    RETIRED*            m_retired;                      // Retired objects waiting for destruction.
+    const void**        m_scratch;                      // Sorted copy of the hazards during scan.
+    int                 m_hazardCount;
+    int                 m_retireCount;
+    int                 m_retiredUsed;
+    int                 m_doomed;                       // Entries in front of m_retired not protected, to destroy.
+    bool                m_scanning;                     // Destroying : scan called from a destructor.
+};
+
+};
+
+#endif
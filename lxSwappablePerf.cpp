@@ -0,0 +1,194 @@
+#include "lxSwappablePerf.h"
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <string.h>
+    #include <time.h>
+    #define LX_PERF_EVENTS
+#elif defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+namespace lx {
+
+#ifdef LX_PERF_EVENTS
+static int openEvent(unsigned int type, unsigned long long config, int groupFd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = type;
+    attr.config         = config;
+    attr.disabled       = (groupFd == -1) ? 1 : 0;  // Only the leader controls the group.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP;
+
+    return (int)syscall(__NR_perf_event_open, &attr, 0 /*this thread*/, -1 /*any cpu*/, groupFd, 0);
+}
+#endif
+
+SwappablePerf::SwappablePerf()
+:m_hardware(false)
+{
+    for (int op=0; op < OP_COUNT; op++) {
+        for (int ev=0; ev < EV_COUNT; ev++) {
+            m_fd  [op][ev] = -1;
+            m_slot[op][ev] = -1;
+        }
+        m_depth[op] = 0;
+    }
+    reset();
+}
+
+bool SwappablePerf::init() {
+    release();
+
+#ifdef LX_PERF_EVENTS
+    const unsigned int       types  [EV_COUNT] = {
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE
+    };
+    const unsigned long long configs[EV_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_CACHE_DTLB
+            | (PERF_COUNT_HW_CACHE_OP_READ     <<  8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+    };
+
+    for (int op=0; op < OP_COUNT; op++) {
+        int leader = openEvent(types[EV_CYCLES], configs[EV_CYCLES], -1);
+        if (leader < 0) {
+            // No PMU access : timing only.
+            release();
+            return false;
+        }
+        m_fd  [op][EV_CYCLES] = leader;
+        m_slot[op][EV_CYCLES] = 0;
+
+        // Siblings are optional, some PMU do not provide all events.
+        int slot = 1;
+        for (int ev=EV_CYCLES+1; ev < EV_COUNT; ev++) {
+            int fd = openEvent(types[ev], configs[ev], leader);
+            if (fd >= 0) {
+                m_fd  [op][ev] = fd;
+                m_slot[op][ev] = slot++;
+            }
+        }
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    }
+    m_hardware = true;
+#endif
+
+    return m_hardware;
+}
+
+void SwappablePerf::release() {
+#ifdef LX_PERF_EVENTS
+    for (int op=0; op < OP_COUNT; op++) {
+        // Close siblings before the leader.
+        for (int ev=EV_COUNT-1; ev >= 0; ev--) {
+            if (m_fd[op][ev] >= 0) {
+                close(m_fd[op][ev]);
+            }
+            m_fd  [op][ev] = -1;
+            m_slot[op][ev] = -1;
+        }
+    }
+#endif
+    m_hardware = false;
+}
+
+void SwappablePerf::reset() {
+    for (int op=0; op < OP_COUNT; op++) {
+        COUNTERS& c     = m_counters[op];
+        c.m_calls       = 0;
+        c.m_nanoseconds = 0;
+        c.m_cycles      = 0;
+        c.m_instructions= 0;
+        c.m_cacheMisses = 0;
+        c.m_tlbMisses   = 0;
+#ifdef LX_PERF_EVENTS
+        if (m_fd[op][EV_CYCLES] >= 0) {
+            ioctl(m_fd[op][EV_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+}
+
+const SwappablePerf::COUNTERS& SwappablePerf::getCounters(OPERATION op) {
+#ifdef LX_PERF_EVENTS
+    if (m_hardware) {
+        // Group read format : { nr, values[nr] }
+        unsigned long long buffer[1 + EV_COUNT];
+        if (read(m_fd[op][EV_CYCLES], buffer, sizeof(buffer)) > 0) {
+            unsigned long long* values[EV_COUNT] = {
+                &m_counters[op].m_cycles,
+                &m_counters[op].m_instructions,
+                &m_counters[op].m_cacheMisses,
+                &m_counters[op].m_tlbMisses
+            };
+            for (int ev=0; ev < EV_COUNT; ev++) {
+                int slot = m_slot[op][ev];
+                if (slot >= 0 && (unsigned long long)slot < buffer[0]) {
+                    *values[ev] = buffer[1 + slot];
+                }
+            }
+        }
+    }
+#endif
+    return m_counters[op];
+}
+
+void SwappablePerf::begin(OPERATION op) {
+    if (m_depth[op]++ != 0) {
+        // Nested inside the same operation kind : the outer one measures.
+        return;
+    }
+#ifdef LX_PERF_EVENTS
+    if (m_hardware) {
+        ioctl(m_fd[op][EV_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#else
+    (void)op;
+#endif
+}
+
+void SwappablePerf::end(OPERATION op, unsigned long long startTime) {
+    if (--m_depth[op] != 0) {
+        return;
+    }
+    unsigned long long endTime = now();
+#ifdef LX_PERF_EVENTS
+    if (m_hardware) {
+        ioctl(m_fd[op][EV_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+    m_counters[op].m_calls++;
+    m_counters[op].m_nanoseconds += endTime - startTime;
+}
+
+/*static*/
+unsigned long long SwappablePerf::now() {
+#if defined(_WIN32)
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter  (&counter);
+    return (unsigned long long)((counter.QuadPart / freq.QuadPart) * 1000000000ULL
+                             + ((counter.QuadPart % freq.QuadPart) * 1000000000ULL) / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+} // End namespace lx
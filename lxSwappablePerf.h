@@ -0,0 +1,143 @@
+/*
+// ====================================================================================
+//  Optional instrumentation layer for the hot-swappable smart pointer library.
+//
+//    - Measure the cost of the manager operations (swap, registration, reference attach).
+//    - Use hardware counters through perf_event_open on Linux :
+//      cycles, instructions, cache misses and data TLB misses.
+//    - Degrade to timing only when counters are not available
+//      (other OS, no PMU access, perf_event_paranoid, virtual machine...)
+//
+//  Usage :
+//    - Compile the library with LX_SWAPPABLE_PERF defined (whole project, it changes the manager layout).
+//    - Create a SwappablePerf instance, call init() and attach it to the manager.
+//    - Read the counters per operation kind with getCounters(...).
+//
+//    SwappablePerf perf;
+//    perf.init();
+//    mgr->setPerf(&perf);
+//    ...
+//    const SwappablePerf::COUNTERS& c = perf.getCounters(SwappablePerf::OP_REPLACE_OBJECT);
+//
+//  Note :
+//  - Counters are accumulated by the kernel only while an operation is running,
+//    each operation kind has its own counter group. Enabling/disabling cost two
+//    system calls per operation : this is a profiling tool, not something to ship.
+//  - Operations nest (a forward or an incremental swap ends in a plain swap) :
+//    only the outermost operation of a kind is measured, one swap is one call.
+//    An operation of another kind running inside it is counted by both kinds.
+//  - Only user space is counted.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_PERF_H
+#define LX_SWAPPABLE_PERF_H
+
+namespace lx {
+
+/*  ====================================================================================
+    Counters per operation kind.
+    ==================================================================================== */
+class SwappablePerf {
+public:
+    /* Operation kinds measured by the manager                                   */
+    enum OPERATION {
+        OP_REPLACE_OBJECT = 0,          // SwappableManager::replaceObject
+        OP_REGISTER,                    // Swappable registration
+        OP_UNREGISTER,                  // Swappable unregistration
+        OP_ATTACH_REFERENCE,            // hotswap_ptr attach to an object reference list
+        OP_COUNT
+    };
+
+    /* Result for one operation kind. Hardware values stay 0 in timing only mode. */
+    struct COUNTERS {
+        unsigned long long  m_calls;            // Number of measured operations.
+        unsigned long long  m_nanoseconds;      // Total wall clock time.
+        unsigned long long  m_cycles;           // CPU cycles.
+        unsigned long long  m_instructions;     // Retired instructions.
+        unsigned long long  m_cacheMisses;      // Last level cache misses.
+        unsigned long long  m_tlbMisses;        // Data TLB read misses.
+    };
+
+    SwappablePerf();
+    ~SwappablePerf() { release(); }
+
+    /* Open the hardware counters.
+       Return true if hardware counters are available, false if only timing is done.
+       The object is usable in both cases.                                       */
+    bool init            ();
+
+    /* Close the hardware counters                                               */
+    void release         ();
+
+    /* Tell if the hardware counters are used                                    */
+    bool hasHardwareCounters() const { return m_hardware; }
+
+    /* Read the counters for an operation kind.
+       Reference is valid until next call for the same operation kind.          */
+    const COUNTERS&
+         getCounters     (OPERATION op);
+
+    /* Reset all counters to zero                                                */
+    void reset           ();
+
+    /* Monotonic clock in nanoseconds, shared with other modules for timing     */
+    static
+    unsigned long long now   ();
+
+    /* Start / stop measuring an operation. Use SwappablePerfScope instead.
+       Calls nested inside an operation of the same kind are not measured.     */
+    void begin           (OPERATION op);
+    void end             (OPERATION op, unsigned long long startTime);
+
+private:
+    /* Hardware event inside a group                                             */
+    enum EVENT {
+        EV_CYCLES = 0,
+        EV_INSTRUCTIONS,
+        EV_CACHE_MISSES,
+        EV_TLB_MISSES,
+        EV_COUNT
+    };
+
+    int         m_fd    [OP_COUNT][EV_COUNT];   // File descriptors, -1 if event not available. [x][0] is group leader.
+    int         m_slot  [OP_COUNT][EV_COUNT];   // Position of the event inside the group read buffer, -1 if not available.
+    COUNTERS    m_counters[OP_COUNT];
+    int         m_depth [OP_COUNT];             // Nesting level of the running operations.
+    bool        m_hardware;
+
+    // No copy.
+    SwappablePerf           (const SwappablePerf&);
+    SwappablePerf& operator=(const SwappablePerf&);
+};
+
+/*  ====================================================================================
+    Measure an operation for the lifetime of the scope. Accept a NULL perf object.
+    ==================================================================================== */
+class SwappablePerfScope {
+public:
+    SwappablePerfScope(SwappablePerf* perf, SwappablePerf::OPERATION op)
+    :m_perf  (perf)
+    ,m_op    (op)
+    ,m_start (0)
+    {
+        if (perf) {
+            perf->begin(op);
+            m_start = SwappablePerf::now();
+        }
+    }
+
+    ~SwappablePerfScope() {
+        if (m_perf) {
+            m_perf->end(m_op, m_start);
+        }
+    }
+private:
+    SwappablePerf*              m_perf;
+    SwappablePerf::OPERATION    m_op;
+    unsigned long long          m_start;
+};
+
+};
+
+#endif
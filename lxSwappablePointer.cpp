@@ -2,22 +2,20 @@
 
 namespace lx {
 
-void SwappableManager::freeSwappable(unsigned int handle) {
+void SwappableManager::freeSwappable(SwappableIndex handle) {
     SLOTLIST* freeEntry = &m_allocList[handle];
-    unsigned int next = (unsigned int)(freeEntry->m_next16 | (freeEntry->m_next8 << 16));
-    unsigned int prev = (unsigned int)(freeEntry->m_prev16 | (freeEntry->m_prev8 << 16));
+    SwappableIndex next = getNext(*freeEntry);
+    SwappableIndex prev = getPrev(*freeEntry);
 
     //
     // Use update
     //
-    if (next != (unsigned int)NULL_IDX) {
-        m_allocList[next].m_prev16 = (unsigned short) prev;
-        m_allocList[next].m_prev8  = (unsigned char )(prev >> 16);
+    if (next != NULL_IDX) {
+        setPrev(m_allocList[next], prev);
     }
 
-    if (prev != (unsigned int)NULL_IDX) {
-        m_allocList[prev].m_next16 = (unsigned short) next;
-        m_allocList[prev].m_next8  = (unsigned char )(next >> 16);
+    if (prev != NULL_IDX) {
+        setNext(m_allocList[prev], next);
     } else {
         m_usedIdxSwappable = next;
     }
@@ -25,78 +23,604 @@ void SwappableManager::freeSwappable(unsigned int handle) {
     //
     // Delete update
     //
-    freeEntry->m_next16 = (unsigned short) m_freeIdxSwappable;
-    freeEntry->m_next8  = (unsigned char )(m_freeIdxSwappable>>16);
+    setNext(*freeEntry, m_freeIdxSwappable);
+    if (m_trackerList) {
+        m_trackerList[handle] = 0;
+    }
+    if (m_stagedIdxSwappable != NULL_IDX) {
+        unstageSwappable(handle, m_arrayList[handle].m_owner);
+    }
+
+    // Forwards to this entry become stale : the entry may be reused by another object.
+    clearForward(handle);
+    m_arrayList[handle].m_generation++;
 
     m_freeIdxSwappable = handle;
     m_freeSwappable++;
 }
 
-unsigned int SwappableManager::allocateSwappable(Swappable* pTracker) {
-    unsigned int oldFree = m_freeIdxSwappable;
-    if (oldFree != (unsigned int)NULL_IDX) {
+void SwappableManager::unstageSwappable(SwappableIndex handle, const void* owner) {
+    // Published entries only wait for the copy to the inactive bank : nothing to cancel.
+    if (m_syncPending) {
+        return;
+    }
+
+    ITEM* active   = m_bankList[m_activeBank];
+    ITEM* inactive = m_bankList[m_activeBank ^ 1];
+    SwappableIndex* link = &m_stagedIdxSwappable;
+    while (*link != NULL_IDX) {
+        SwappableIndex staged = *link;
+        if ((staged == handle) || (inactive[staged].m_target == owner)) {
+            // Back to the published target, a later flip must not publish a dead object.
+            writeItem(inactive[staged], active[staged].m_target);
+            *link = m_stagedList[staged];
+            m_stagedList[staged] = STAGED_NONE;
+        } else {
+            link = &m_stagedList[staged];
+        }
+    }
+}
+
+SwappableIndex SwappableManager::allocateSwappable(const void* owner) {
+    SwappableIndex oldFree = m_freeIdxSwappable;
+    if ((oldFree != NULL_IDX) || (m_highWater < m_totalSwappable)) {
         //
-        // Update free list.
+        // Update free list, or take a never used entry : they stay contiguous for merge().
         //
-        SLOTLIST* newEntry = &m_allocList[oldFree];
-        m_freeIdxSwappable = (unsigned int  )(newEntry->m_next16 | (newEntry->m_next8 << 16));
-        newEntry->m_next16 = (unsigned short) m_usedIdxSwappable;
-        newEntry->m_next8  = (unsigned char )(m_usedIdxSwappable>>16);
-        newEntry->m_prev16 = NULL_IDX16;
-        newEntry->m_prev8  = NULL_IDX8;
+        SLOTLIST* newEntry;
+        if (oldFree != NULL_IDX) {
+            newEntry           = &m_allocList[oldFree];
+            m_freeIdxSwappable = getNext(*newEntry);
+        } else {
+            oldFree            = m_highWater++;
+            newEntry           = &m_allocList[oldFree];
+        }
+        setNext(*newEntry, m_usedIdxSwappable);
+        setPrev(*newEntry, NULL_IDX);
 
         // No need to update LEFT of next free item -> m_connection[free].m_prev = NULL_ID;
-        if (m_usedIdxSwappable != (unsigned int)NULL_IDX) {
-            m_allocList[m_usedIdxSwappable].m_prev16 = (unsigned short) oldFree;
-            m_allocList[m_usedIdxSwappable].m_prev8  = (unsigned char )(oldFree>>16);
+        if (m_usedIdxSwappable != NULL_IDX) {
+            setPrev(m_allocList[m_usedIdxSwappable], oldFree);
         }
 
         m_usedIdxSwappable = oldFree;
-        m_arrayList[oldFree].m_item        = pTracker;
+        m_arrayList[oldFree].m_owner       = owner;
         m_arrayList[oldFree].m_linkList    = 0;
+        m_arrayList[oldFree].m_forward     = NULL_IDX;
+        m_arrayList[oldFree].m_forwardIn   = 0;
+        m_arrayList[oldFree].m_shared      = 0;
+        writeItem(m_arrayList[oldFree], owner);
+        if (m_bankList[1] != m_arrayList) {
+            writeItem(m_bankList[1][oldFree], owner);
+        }
+#if LX_SWAPPABLE_VERSIONS > 0
+        m_arrayList[oldFree].m_since       = m_tick;
+        m_arrayList[oldFree].m_versionHead = 0;
+        for (int n=0; n < LX_SWAPPABLE_VERSIONS; n++) {
+            m_arrayList[oldFree].m_versions[n].m_owner = 0;
+        }
+#endif
         m_freeSwappable--;
 
         return oldFree;
-    } else {
-
     }
-    return ((unsigned int)-1);
+    return NULL_IDX;
 }
 
 void SwappableManager::replaceObject    (Swappable* oldInstance, Swappable* newInstance) {
-    unsigned int handleOld = oldInstance->m_handle;
+    replaceSlot(oldInstance->getSlot(), newInstance->getSlot());
+}
+
+void SwappableManager::replaceSlot      (SwappableIndex handleOld, SwappableIndex handleNew) {
+    LX_SWAPPABLE_PERF_SCOPE(this, OP_REPLACE_OBJECT);
+    if (handleOld == handleNew) {
+        return;
+    }
+
+    // An incremental swap to the same instance already recorded the version.
+    if (getForward(handleOld) != handleNew) {
+        pushVersion(handleOld, handleNew);
+    }
+
     SwappableInstance* pStart    = m_arrayList[handleOld].m_linkList;
     SwappableInstance* pInstance = pStart;
     SwappableInstance* pPrev     = 0;
 
     // Patch the memory with the new link list.
+    // Release store : readers on other threads (hotswap_atomic_ptr) see a constructed object.
+    const void* newOwner = m_arrayList[handleNew].m_owner;
     while (pInstance) {
-        pInstance->ptr = newInstance->m_owner;
+        SwappableAtomic::storeRelease(&pInstance->ptr, newOwner);
         pPrev = pInstance;
         pInstance = pInstance->next;
     }
 
     if (pPrev) {
-        // TODO
+        // Move the link list to new instance link list :
+        // existing references of the new instance are appended after the moved ones.
+        SwappableInstance* pNewHead = m_arrayList[handleNew].m_linkList;
+        pPrev->next = pNewHead;
+        if (pNewHead) {
+            setPrevLink(pNewHead, pPrev);
+        }
+        m_arrayList[handleNew].m_linkList = pStart;
+        m_arrayList[handleOld].m_linkList = 0;
+    }
+
+    // Owners moved with the references.
+    m_arrayList[handleNew].m_shared += m_arrayList[handleOld].m_shared;
+    m_arrayList[handleOld].m_shared  = 0;
+
+    // All the references moved : a forward is only needed for the entries forwarding
+    // to the old one (lazy or incremental swaps in progress), to reach the new one.
+    // A forward of the new instance stays unless it leads back (ie swap back) :
+    // its references not healed yet still move on.
+    if (m_arrayList[handleOld].m_forwardIn != 0) {
+        setForward(handleOld, handleNew);
+    } else {
+        if (forwardsTo(handleNew, handleOld)) {
+            clearForward(handleNew);
+        }
+        clearForward(handleOld);
+    }
+}
+
+bool SwappableManager::replaceObjectIncremental(Swappable* oldInstance, Swappable* newInstance, int maxPatch) {
+    LX_SWAPPABLE_PERF_SCOPE(this, OP_REPLACE_OBJECT);
+    SwappableIndex handleOld = oldInstance->getSlot();
+    SwappableIndex handleNew = newInstance->getSlot();
+    if (handleOld == handleNew) {
+        return true;
+    }
+
+    ITEM& itemOld = m_arrayList[handleOld];
+    if (itemOld.m_shared != 0) {
+        // Owning references are not known one by one : move them all with the count.
+        replaceSlot(handleOld, handleNew);
+        return true;
+    }
+
+    if (getForward(handleOld) != handleNew) {
+        // First step : references not patched yet forward to the new instance.
+        pushVersion(handleOld, handleNew);
+        setForward(handleOld, handleNew);
+    }
+
+    // Move references one by one from the head of the old list.
+    const void*        newOwner  = m_arrayList[handleNew].m_owner;
+    SwappableInstance* pInstance = itemOld.m_linkList;
+    while (pInstance && (maxPatch > 0)) {
+        SwappableInstance* pNext = pInstance->next;
+        SwappableAtomic::storeRelease(&pInstance->ptr, newOwner);
+        addListStart(pInstance, handleNew);
+        pInstance = pNext;
+        maxPatch--;
+    }
+
+    itemOld.m_linkList = pInstance;
+    if (pInstance) {
+        setPrevLink(pInstance, 0);
+        return false;
+    }
+
+    // Done : keep the forward only for the entries forwarding to the old one.
+    if (itemOld.m_forwardIn == 0) {
+        clearForward(handleOld);
     }
+    return true;
+}
+
+size_t SwappableManager::replaceGroup   (Swappable* oldInstance, Swappable* newInstance, unsigned int group) {
+    if (group > MAX_GROUP) {
+        // Not a group any reference can be in.
+        return 0;
+    }
+    return moveFiltered(oldInstance->getSlot(), newInstance->getSlot(), &SwappableManager::groupFilter, (void*)(size_t)group);
+}
 
-    // Move the link list to new instance link list.
+size_t SwappableManager::replaceFiltered(Swappable* oldInstance, Swappable* newInstance, ReferenceFilter filter, void* context) {
+    return moveFiltered(oldInstance->getSlot(), newInstance->getSlot(), filter, context);
 }
 
 /*static*/
-int SwappableManager::getAllocSize(int SwappableMaxCount) {
-    unsigned int bufferSizeTrackList         = SwappableMaxCount * sizeof(ITEM    );
-    unsigned int bufferSizeTrackListAlloc    = SwappableMaxCount * sizeof(SLOTLIST);
-    return (int)(bufferSizeTrackList + bufferSizeTrackListAlloc);
+bool SwappableManager::groupFilter      (void* context, const void* reference) {
+    return getGroup((const SwappableInstance*)reference) == (unsigned int)(size_t)context;
+}
+
+size_t SwappableManager::moveFiltered   (SwappableIndex handleOld, SwappableIndex handleNew, ReferenceFilter filter, void* context) {
+    LX_SWAPPABLE_PERF_SCOPE(this, OP_REPLACE_OBJECT);
+    if ((handleOld == handleNew) || (m_arrayList[handleOld].m_shared != 0)) {
+        // Owning references are not known one by one : the count could not follow.
+        return 0;
+    }
+
+    const void*        newOwner  = m_arrayList[handleNew].m_owner;
+    SwappableInstance* pInstance = m_arrayList[handleOld].m_linkList;
+    size_t             moved     = 0;
+    while (pInstance) {
+        SwappableInstance* pNext = pInstance->next;
+        if (filter(context, pInstance)) {
+            removeReference(pInstance, handleOld);
+            SwappableAtomic::storeRelease(&pInstance->ptr, newOwner);
+            addListStart(pInstance, handleNew);
+            moved++;
+        }
+        pInstance = pNext;
+    }
+    return moved;
+}
+
+void SwappableManager::forwardObject    (Swappable* oldInstance, Swappable* newInstance) {
+    LX_SWAPPABLE_PERF_SCOPE(this, OP_REPLACE_OBJECT);
+    SwappableIndex handleOld = oldInstance->getSlot();
+    SwappableIndex handleNew = newInstance->getSlot();
+    if ((handleOld == handleNew) || (getForward(handleOld) == handleNew)) {
+        return;
+    }
+
+    if (m_arrayList[handleOld].m_shared != 0) {
+        // Owning references are not known one by one : move them all with the count.
+        replaceSlot(handleOld, handleNew);
+        return;
+    }
+
+    pushVersion(handleOld, handleNew);
+    setForward(handleOld, handleNew);
+}
+
+void SwappableManager::setForward       (SwappableIndex handleOld, SwappableIndex handleNew) {
+    // New instance is current again if its chain leads back to the old one (ie swap back) :
+    // no cycle. Otherwise its forward stays, the chain goes on past it.
+    if (forwardsTo(handleNew, handleOld)) {
+        clearForward(handleNew);
+    }
+    clearForward(handleOld);
+
+    m_arrayList[handleOld].m_forwardGen = m_arrayList[handleNew].m_generation;
+    m_arrayList[handleNew].m_forwardIn++;
+    SwappableAtomic::storeRelease(&m_arrayList[handleOld].m_forward, handleNew);
+}
+
+bool SwappableManager::forwardsTo       (SwappableIndex handle, SwappableIndex target) const {
+    // Chains never loop : setForward cuts them on swap back.
+    for (SwappableIndex next = getForward(handle); next != NULL_IDX; next = getForward(next)) {
+        if (next == target) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SwappableManager::clearForward     (SwappableIndex handle) {
+    // A stale forward was already dropped from the count when its entry was reused.
+    SwappableIndex target = getForward(handle);
+    if (target != NULL_IDX) {
+        m_arrayList[target].m_forwardIn--;
+    }
+    SwappableAtomic::storeRelease(&m_arrayList[handle].m_forward, NULL_IDX);
+}
+
+const void* SwappableManager::healReference(SwappableInstance* wrapper, SwappableIndex handle) {
+    SwappableIndex target = getForward(handle);
+    if (target == NULL_IDX) {
+        // Forward entry was freed since : the reference stays on its object.
+        clearForward(handle);
+        return m_arrayList[handle].m_owner;
+    }
+
+    // Swaps can be chained before the reference is used : go to the end.
+    SwappableIndex next;
+    while ((next = getForward(target)) != NULL_IDX) {
+        target = next;
+    }
+
+    if (m_arrayList[handle].m_shared != 0) {
+        // Owners were added after the forward : move them all with the count.
+        replaceSlot(handle, target);
+        return m_arrayList[target].m_owner;
+    }
+
+    // Remove from the old list.
+    removeReference(wrapper, handle);
+
+    const void* owner = m_arrayList[target].m_owner;
+    SwappableAtomic::storeRelease(&wrapper->ptr, owner);
+    addListStart(wrapper, target);
+
+    // Last reference moved : keep the forward only for the entries forwarding here.
+    if ((m_arrayList[handle].m_linkList == 0) && (m_arrayList[handle].m_forwardIn == 0)) {
+        clearForward(handle);
+    }
+    return owner;
+}
+
+void SwappableManager::pushVersion      (SwappableIndex handleOld, SwappableIndex handleNew) {
+#if LX_SWAPPABLE_VERSIONS > 0
+    // New instance inherits the history of the old one, old instance is pushed on top.
+    ITEM& itemOld = m_arrayList[handleOld];
+    ITEM& itemNew = m_arrayList[handleNew];
+    for (int n=0; n < LX_SWAPPABLE_VERSIONS; n++) {
+        itemNew.m_versions[n] = itemOld.m_versions[n];
+    }
+    VERSION& top    = itemNew.m_versions[itemOld.m_versionHead];
+    top.m_owner     = itemOld.m_owner;
+    top.m_since     = itemOld.m_since;
+    itemNew.m_versionHead = (itemOld.m_versionHead + 1) % LX_SWAPPABLE_VERSIONS;
+    itemNew.m_since = m_tick;
+#else
+    (void)handleOld;
+    (void)handleNew;
+#endif
 }
 
-bool SwappableManager::init(void* alignPtr_buffer, int bufferSize, int SwappableMaxCount) {
+#if LX_SWAPPABLE_VERSIONS > 0
+const void* SwappableManager::getOwnerAtTick(SwappableIndex handle, unsigned int tick) const {
+    const ITEM& item = m_arrayList[handle];
+    if (tick >= item.m_since) {
+        return item.m_owner;
+    }
+
+    // Walk from the most recent version to the oldest.
+    unsigned int idx = item.m_versionHead;
+    for (int n=0; n < LX_SWAPPABLE_VERSIONS; n++) {
+        idx = (idx + LX_SWAPPABLE_VERSIONS - 1) % LX_SWAPPABLE_VERSIONS;
+        const VERSION& version = item.m_versions[idx];
+        if (version.m_owner == 0) {
+            break;
+        }
+        if (tick >= version.m_since) {
+            return version.m_owner;
+        }
+    }
+    return 0;
+}
+#endif
+
+void SwappableManager::queueSwap        (SwapRequest* request) {
+    request->m_next = 0;
+    if (m_pendingTail) {
+        m_pendingTail->m_next = request;
+    } else {
+        m_pendingHead = request;
+    }
+    m_pendingTail = request;
+}
+
+int SwappableManager::drainSwaps        () {
+    // Detach the pending list first : completion callbacks may queue for the next drain.
+    SwapRequest* pRequest = m_pendingHead;
+    m_pendingHead = 0;
+    m_pendingTail = 0;
+
+    int count = 0;
+    while (pRequest) {
+        // Request memory belongs to the caller and may be gone after completion.
+        SwapRequest* pNext = pRequest->m_next;
+        replaceObject(pRequest->m_oldInstance, pRequest->m_newInstance);
+        if (pRequest->m_retireOld) {
+            retire((void*)m_arrayList[pRequest->m_oldInstance->getSlot()].m_owner, pRequest->m_retireOld);
+        }
+        if (pRequest->m_onDone) {
+            pRequest->m_onDone(pRequest);
+        }
+        pRequest = pNext;
+        count++;
+    }
+    return count;
+}
+
+/*static*/
+size_t SwappableManager::getBankAllocSize(size_t SwappableMaxCount) {
+    size_t bufferSizeBank                    = SwappableMaxCount * sizeof(ITEM          );
+    size_t bufferSizeStaged                  = SwappableMaxCount * sizeof(SwappableIndex);
+    return bufferSizeBank + bufferSizeStaged;
+}
+
+bool SwappableManager::enableBanks(void* alignPtr_buffer, size_t bufferSize) {
+    if (bufferSize < getBankAllocSize(m_totalSwappable)) {
+        return false;
+    }
+
+    ITEM* mirror            = (ITEM*)alignPtr_buffer;
+    m_stagedList            = (SwappableIndex*)&mirror[m_totalSwappable];
+    for (SwappableIndex n=0; n < m_totalSwappable; n++) {
+        mirror[n].m_owner   = m_arrayList[n].m_owner;
+        mirror[n].m_target  = m_arrayList[n].m_target;
+        m_stagedList[n]     = STAGED_NONE;
+    }
+    m_stagedIdxSwappable    = NULL_IDX;
+    m_syncPending           = false;
+    m_activeBank            = 0;
+    m_bankList[1]           = mirror;
+    return true;
+}
+
+void SwappableManager::stageSwap(Swappable* oldInstance, Swappable* newInstance) {
+    if (m_syncPending) {
+        syncBanks();
+    }
+
+    ITEM*          inactive  = m_bankList[m_activeBank ^ 1];
+    SwappableIndex handle    = oldInstance->getSlot();
+    SwappableIndex handleNew = newInstance->getSlot();
+    const void*    oldOwner  = m_arrayList[handle].m_owner;
+    // New instance may itself be replaced : go to its target.
+    const void*    newTarget = inactive[handleNew].m_target;
+    if ((handleNew == handle) || (newTarget == oldOwner)) {
+        // Back to itself, or swap back (A->B then B->A) : both end on the new instance.
+        newTarget = m_arrayList[handleNew].m_owner;
+    }
+
+    if (m_stagedList) {
+        // Entries already staged to the old instance follow it.
+        SwappableIndex staged = m_stagedIdxSwappable;
+        while (staged != NULL_IDX) {
+            if (inactive[staged].m_target == oldOwner) {
+                writeItem(inactive[staged], newTarget);
+            }
+            staged = m_stagedList[staged];
+        }
+
+        if (m_stagedList[handle] == STAGED_NONE) {
+            m_stagedList[handle] = m_stagedIdxSwappable;
+            m_stagedIdxSwappable = handle;
+        }
+    }
+    writeItem(inactive[handle], newTarget);
+}
+
+void SwappableManager::flipBanks() {
+    if (m_syncPending) {
+        syncBanks();
+    }
+
+    // Single store : readers see all the staged entries or none of them.
+    SwappableAtomic::storeRelease(&m_activeBank, m_activeBank ^ 1);
+    m_syncPending = true;
+}
+
+bool SwappableManager::trySyncBanks() {
+    if (m_syncPending) {
+        ITEM* active   = m_bankList[m_activeBank];
+        ITEM* inactive = m_bankList[m_activeBank ^ 1];
+
+        // Grace period : readers entered before the flip must have left the previous bank.
+        // New readers can not enter it anymore, they see the flip (see enterRead).
+        SwappableAtomic::fence();
+        if (SwappableAtomic::loadAcquire(&m_readers[m_activeBank ^ 1]) != 0) {
+            return false;
+        }
+
+        SwappableIndex handle = m_stagedIdxSwappable;
+        while (handle != NULL_IDX) {
+            SwappableIndex next = m_stagedList[handle];
+            writeItem(inactive[handle], active[handle].m_target);
+            m_stagedList[handle]    = STAGED_NONE;
+            handle = next;
+        }
+        m_stagedIdxSwappable = NULL_IDX;
+        m_syncPending        = false;
+    }
+    return true;
+}
+
+void SwappableManager::syncBanks() {
+    while (!trySyncBanks()) {
+        // Readers hold a bank for a few loads only.
+    }
+}
+
+#ifndef LX_SWAPPABLE_NO_STAGING
+/*static*/
+size_t SwappableManager::getStagingAllocSize(size_t SwappableMaxCount) {
+    return SwappableMaxCount * sizeof(Swappable*);
+}
+
+bool SwappableManager::enableStaging(void* alignPtr_buffer, size_t bufferSize) {
+    if ((m_highWater != 0) || (bufferSize < getStagingAllocSize(m_totalSwappable))) {
+        return false;
+    }
+
+    m_trackerList = (Swappable**)alignPtr_buffer;
+    for (SwappableIndex n=0; n < m_totalSwappable; n++) {
+        m_trackerList[n] = 0;
+    }
+    return true;
+}
+
+bool SwappableManager::merge(SwappableManager* staging) {
+    SwappableIndex count = staging->m_highWater;
+    if ((staging->m_trackerList == 0) || (staging == this) || ((m_totalSwappable - m_highWater) < count)) {
+        return false;
+    }
+
+    //
+    // Single pass over the staging entries : copy, rebase, and rebuild the allocator lists.
+    //
+    SwappableIndex base = m_highWater;
+    SwappableIndex used = 0;
+    for (SwappableIndex n=0; n < count; n++) {
+        SwappableIndex handle  = base + n;
+        Swappable*     tracker = staging->m_trackerList[n];
+        staging->m_trackerList[n] = 0;
+
+        if (tracker) {
+            ITEM& item = m_arrayList[handle];
+            item = staging->m_arrayList[n];
+            if (item.m_forward != NULL_IDX) {
+                item.m_forward += base;
+            }
+            if (m_bankList[1] != m_arrayList) {
+                m_bankList[1][handle].m_owner = item.m_owner;
+                writeItem(m_bankList[1][handle], item.m_target);
+            }
+
+            setNext(m_allocList[handle], m_usedIdxSwappable);
+            setPrev(m_allocList[handle], NULL_IDX);
+            if (m_usedIdxSwappable != NULL_IDX) {
+                setPrev(m_allocList[m_usedIdxSwappable], handle);
+            }
+            m_usedIdxSwappable = handle;
+
+            tracker->setHandle(this, handle);
+            if (m_trackerList) {
+                m_trackerList[handle] = tracker;
+            }
+            used++;
+        } else {
+            // Freed during staging.
+            setNext(m_allocList[handle], m_freeIdxSwappable);
+            m_freeIdxSwappable = handle;
+        }
+    }
+    m_highWater    += count;
+    m_freeSwappable -= used;
+
+    // Staging manager is empty again.
+    staging->m_highWater        = 0;
+    staging->m_freeSwappable    = staging->m_totalSwappable;
+    staging->m_usedIdxSwappable = NULL_IDX;
+    staging->m_freeIdxSwappable = NULL_IDX;
+    return true;
+}
+#endif
+
+#ifdef LX_SWAPPABLE_COMPACT
+/*static*/
+SwappableManager* SwappableManager::s_registry[SwappableManager::MAX_MANAGERS];
+
+void SwappableManager::release() {
+    SwappableAtomic::storeRelease(&s_registry[m_registryId], (SwappableManager*)0);
+}
+#endif
+
+/*static*/
+size_t SwappableManager::getAllocSize(size_t SwappableMaxCount) {
+    size_t bufferSizeTrackList               = SwappableMaxCount * sizeof(ITEM    );
+    size_t bufferSizeTrackListAlloc          = SwappableMaxCount * sizeof(SLOTLIST);
+    return bufferSizeTrackList + bufferSizeTrackListAlloc;
+}
+
+bool SwappableManager::init(void* alignPtr_buffer, size_t bufferSize, size_t SwappableMaxCount) {
     // 1. Array of Swappable Instance.
-    unsigned int bufferSizeTrackList         = SwappableMaxCount * sizeof(ITEM    );
-    unsigned int bufferSizeTrackListAlloc    = SwappableMaxCount * sizeof(SLOTLIST);
+    size_t bufferSizeTrackList               = SwappableMaxCount * sizeof(ITEM    );
+    size_t bufferSizeTrackListAlloc          = SwappableMaxCount * sizeof(SLOTLIST);
+
+    // 2. If user give space is enough, and indices fit below the reserved values.
+    if ((SwappableMaxCount <= STAGED_NONE) && (bufferSize >= (bufferSizeTrackList + bufferSizeTrackListAlloc))) {
+#ifdef LX_SWAPPABLE_COMPACT
+        // Compact handles hold an id instead of the manager pointer.
+        // Ids are claimed atomically : staging managers are created on loader threads.
+        unsigned int id = 0;
+        while ((id < MAX_MANAGERS) && !SwappableAtomic::compareExchange(&s_registry[id], (SwappableManager*)0, this)) {
+            id++;
+        }
+        if (id == MAX_MANAGERS) {
+            return false;
+        }
+        m_registryId           = id;
+#endif
 
-    // 2. If user give space is enough
-    if ((unsigned int)bufferSize >= (bufferSizeTrackList + bufferSizeTrackListAlloc)) {
         unsigned char* ptr     = (unsigned char*)alignPtr_buffer;
         // List of Swappable
         m_arrayList            = (ITEM*)ptr;
@@ -106,24 +630,43 @@ bool SwappableManager::init(void* alignPtr_buffer, int bufferSize, int Swappable
         //
         // Internal allocator double link list setup.
         //
-        m_freeSwappable        = (unsigned int)SwappableMaxCount;
+        m_freeSwappable        = (SwappableIndex)SwappableMaxCount;
         m_totalSwappable       = m_freeSwappable;
 
         m_usedIdxSwappable     = NULL_IDX;
-        m_freeIdxSwappable     = 0;
+        m_freeIdxSwappable     = NULL_IDX;
+        m_highWater            = 0;
+        m_trackerList          = 0;
+        m_bankList[0]          = m_arrayList;
+        m_bankList[1]          = m_arrayList;
+        m_activeBank           = 0;
+        m_readers[0]           = 0;
+        m_readers[1]           = 0;
+        m_stagedList           = 0;
+        m_stagedIdxSwappable   = NULL_IDX;
+        m_syncPending          = false;
 
-        int n;
-        for (n=0; n < (int)m_freeSwappable; n++) {
-            int idx = n + 1;
-            m_allocList[n].m_next16    = (unsigned short)idx;
-            m_allocList[n].m_next8     = (unsigned char )(idx>>16);
+        m_retireHandler        = 0;
+        m_retireContext        = 0;
+        m_pendingHead          = 0;
+        m_pendingTail          = 0;
+#if LX_SWAPPABLE_VERSIONS > 0
+        m_tick                 = 0;
+#endif
+#ifdef LX_SWAPPABLE_PERF
+        m_perf                 = 0;
+#endif
 
-            idx = n - 1;
-            m_allocList[n].m_prev16    = (unsigned short)idx;
-            m_allocList[n].m_prev8     = (unsigned char )(idx>>16);
+        // Allocator links are set when entries are first used.
+        for (SwappableIndex n=0; n < m_freeSwappable; n++) {
+            m_arrayList[n].m_owner      = 0;
+            m_arrayList[n].m_target     = 0;
+            m_arrayList[n].m_forward    = NULL_IDX;
+            m_arrayList[n].m_forwardGen = 0;
+            m_arrayList[n].m_forwardIn  = 0;
+            m_arrayList[n].m_generation = 0;
+            m_arrayList[n].m_shared     = 0;
         }
-        m_allocList[n].m_next16   = NULL_IDX16;
-        m_allocList[n].m_next8    = NULL_IDX8;
 
         return true;
     } else {
@@ -131,16 +674,22 @@ bool SwappableManager::init(void* alignPtr_buffer, int bufferSize, int Swappable
     }
 }
 
-void Swappable::registerObject    (Swappable* tracker) {
-    int handle = (int)m_mgr->allocateSwappable(tracker);
-    if (handle >= 0) {
-        tracker->m_handle = (unsigned int)handle;
+void Swappable::registerObject    (void* obj, SwappableManager* mgr) {
+    LX_SWAPPABLE_PERF_SCOPE(mgr, OP_REGISTER);
+    // NULL_IDX if the manager is full : object is not tracked.
+    SwappableIndex handle = mgr->allocateSwappable(obj);
+    setHandle(mgr, handle);
+    if (mgr->m_trackerList && (handle != SwappableManager::NULL_IDX)) {
+        mgr->m_trackerList[handle] = this;
     }
 }
 
-void Swappable::unregisterObject(Swappable* tracker) {
+void Swappable::unregisterObject() {
+    LX_SWAPPABLE_PERF_SCOPE(getManager(), OP_UNREGISTER);
     // Free the handle
-    m_mgr->freeSwappable(tracker->m_handle);
+    if (getSlot() != SwappableManager::NULL_IDX) {
+        getManager()->freeSwappable(getSlot());
+    }
 }
 
 } // End namespace lx
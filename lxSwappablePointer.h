@@ -100,10 +100,63 @@ Sample Usage here :
  */
 
 #include <cstddef>
+#include <new>
+#include "lxSwappableAtomic.h"
+
+/* Number of previous owners kept per registered object for reads at a given tick.
+   0 disables versioning and keeps the manager entries at their minimum size.   */
+#ifndef LX_SWAPPABLE_VERSIONS
+    #define LX_SWAPPABLE_VERSIONS    0
+#endif
+
+/* Width in bits of the slot index : 16, 24 (default), 32 or 48. A manager tracks at
+   most 2^bits - 2 objects, the two highest values are reserved.
+   24 packs the allocator links, 32 uses naturally aligned storage, 48 widens the
+   indices to 64 bit integers.                                                     */
+#ifndef LX_SWAPPABLE_INDEX_BITS
+    #define LX_SWAPPABLE_INDEX_BITS  24
+#endif
+
+/* Define LX_SWAPPABLE_COMPACT to shrink the member added by MAKESWAPPABLE to a single
+   handle holding the manager id (up to 256 live managers) above the slot :
+   32 bit handle with 16 and 24 bit indices, 64 bit handle with 48 bit indices.
+   With 32 bit indices there is no spare bit : only one manager can be alive.
+   Otherwise it holds the manager pointer and the slot.                             */
+
+/* Define LX_SWAPPABLE_NO_STAGING to remove staging managers (enableStaging, merge).
+   Required by LX_SWAPPABLE_COMPACT with 32 bit indices : a staging manager is a
+   second manager alive.                                                           */
+#if defined(LX_SWAPPABLE_COMPACT) && (LX_SWAPPABLE_INDEX_BITS == 32) && !defined(LX_SWAPPABLE_NO_STAGING)
+    #error "LX_SWAPPABLE_COMPACT with 32 bit indices has a single manager : define LX_SWAPPABLE_NO_STAGING"
+#endif
+
+#ifdef LX_SWAPPABLE_PERF
+    #include "lxSwappablePerf.h"
+    // Measure the enclosing scope as an operation of the given kind.
+    #define LX_SWAPPABLE_PERF_SCOPE(mgr, op)  lx::SwappablePerfScope _perfScope((mgr)->m_perf, lx::SwappablePerf::op)
+#else
+    #define LX_SWAPPABLE_PERF_SCOPE(mgr, op)
+#endif
 
 namespace lx {
 
 class Swappable;
+class SwapAwaitable;
+
+/* Slot index inside a manager, wide enough for LX_SWAPPABLE_INDEX_BITS        */
+#if LX_SWAPPABLE_INDEX_BITS == 48
+typedef unsigned long long  SwappableIndex;
+#elif (LX_SWAPPABLE_INDEX_BITS == 16) || (LX_SWAPPABLE_INDEX_BITS == 24) || (LX_SWAPPABLE_INDEX_BITS == 32)
+typedef unsigned int        SwappableIndex;
+#else
+    #error "LX_SWAPPABLE_INDEX_BITS must be 16, 24, 32 or 48"
+#endif
+
+/* Destroy a retired object, typically calls delete on the real type (see SwappableManager::destroyObject). */
+typedef void (*SwappableDestroyFunc)(void* object);
+
+/* Receive objects retired by the manager and decide when to destroy them.    */
+typedef void (*SwappableRetireFunc)(void* context, void* object, SwappableDestroyFunc destroy);
 
 /*  ====================================================================================
     Manager tracking all the swappable objects.
@@ -114,19 +167,194 @@ public:
     /* Function for the client to know how much memory is needed in advance before
        doing calling the init(...) function */
     static
-    int     getAllocSize    (int SwappableMaxCount);
+    size_t  getAllocSize    (size_t SwappableMaxCount);
 
     /* Setup buffer used by the manager to track our instances.
        - Set the buffer used for tracking, size of the buffer given.
        - Set the buffer size to be sure.
-       - Maximum number of instances tracked. Maximum is 0xFFFFFF
-       Return true if successful, false if memory was not big enough.            */
-    bool init            (void* alignPtr_buffer, int bufferSize, int SwappableMaxCount);
+       - Maximum number of instances tracked. Maximum is 2^LX_SWAPPABLE_INDEX_BITS - 2
+       Return true if successful, false if memory was not big enough or count too big. */
+    bool init            (void* alignPtr_buffer, size_t bufferSize, size_t SwappableMaxCount);
 
     /* Just a clean interface for future extension.
        Manager should NEVER be destroyed before anything else.
        (May be do assert here to check that somebody is still in the room...)    */
+#ifdef LX_SWAPPABLE_COMPACT
+    void release        ();
+#else
     void release        () { }
+#endif
+
+    /* Deferred swap request. Memory is owned by the caller and must stay valid
+       until the completion callback is called.                                  */
+    struct SwapRequest {
+        Swappable*      m_oldInstance;                   // Object to replace.
+        Swappable*      m_newInstance;                   // Object receiving all the references.
+        void          (*m_onDone)(SwapRequest* request); // Called after the swap, can be NULL.
+        SwappableDestroyFunc m_retireOld;                // Retire the old object after the swap, can be NULL.
+        void*           m_userData;                      // Free for the caller.
+        SwapRequest*    m_next;                          // Internal, pending list.
+    };
+
+    /* Queue a swap to be executed at the next drainSwaps() call.
+       Both objects must be registered in this manager.                          */
+    void queueSwap      (SwapRequest* request);
+
+    /* Execute all the queued swaps in order and call their completion callback.
+       Swaps queued from a callback are executed at the next drain.
+       Return the number of swaps executed.                                      */
+    int  drainSwaps     ();
+
+    /* Install the handler receiving retired objects (ie SwappableHazard), NULL to
+       destroy them immediately.                                                 */
+    void setRetireHandler(SwappableRetireFunc handler, void* context) {
+        m_retireHandler = handler;
+        m_retireContext = context;
+    }
+
+    /* Hand over destruction of an object which is not referenced anymore.
+       Destroyed now if no handler is installed.                                 */
+    void retire          (void* object, SwappableDestroyFunc destroy) {
+        if (m_retireHandler) {
+            m_retireHandler(m_retireContext, object, destroy);
+        } else {
+            destroy(object);
+        }
+    }
+
+    /* Default destroy function for objects allocated with new, object is the owner pointer */
+    template<class T>
+    static void destroyObject(void* object);
+
+    /* Incremental swap for objects with a lot of references : move at most
+       maxPatch references per call, call again (ie next frame) until it returns true.
+       Meanwhile the old entry forwards to the new one, so checked accesses
+       (hotswap_ptr::resolve) on references not moved yet see the new instance.
+       Old instance must stay alive until the swap is finished, the forward is
+       removed then. An old instance with owning references (hotswap_shared_ptr)
+       is swapped at once : the owners and their count move together.           */
+    bool replaceObjectIncremental(Swappable* oldInstance, Swappable* newInstance, int maxPatch);
+
+    /* Lazy swap in O(1) : the old entry forwards to the new one and each
+       reference moves itself on its next checked access (hotswap_ptr::resolve).
+       Only references actually used pay the patch. Old instance must stay alive
+       until all its references moved, or finish with replaceObject (ie hotSwapTo)
+       before destroying it. Same for instances in the middle of a forward chain.
+       A forward to an instance destroyed since is ignored : references stay.
+       An old instance with owning references (hotswap_shared_ptr) is swapped at
+       once, also if they were added after the forward.                          */
+    void forwardObject   (Swappable* oldInstance, Swappable* newInstance);
+
+    /* Reference filter for selective swaps, reference is the hotswap_ptr address */
+    typedef bool (*ReferenceFilter)(void* context, const void* reference);
+
+    /* Highest group id of a reference (hotswap_ptr::setGroup) : groups are stored
+       in the alignment bits of the links, 0..3 on 32 bit, 0..7 on 64 bit.        */
+    static const unsigned int MAX_GROUP = sizeof(void*) - 1;
+
+    /* Selective swap (ie canary) : move only the references of a group
+       (hotswap_ptr::setGroup) to the new instance, in a single walk of the list.
+       Other references stay on the old instance, which is not forwarded.
+       An old instance with owning references (hotswap_shared_ptr) is not split :
+       nothing is moved.
+       Return the number of references moved, 0 if group is above MAX_GROUP.    */
+    size_t replaceGroup  (Swappable* oldInstance, Swappable* newInstance, unsigned int group);
+
+    /* Same as replaceGroup, references accepted by the filter are moved.       */
+    size_t replaceFiltered(Swappable* oldInstance, Swappable* newInstance, ReferenceFilter filter, void* context);
+
+    /* Awaitable swap for C++20 coroutines, resumes the coroutine after the next drain.
+       Defined in lxSwappableCoroutine.h                                         */
+    template<class T>
+    SwapAwaitable swapAsync (T* oldObj, T* newObj);
+
+    /* Function for the client to know how much memory enableBanks(...) needs   */
+    static
+    size_t  getBankAllocSize(size_t SwappableMaxCount);
+
+    /* Enable double buffered resolution for handle references (hotswap_handle).
+       Handles resolve through the active bank, swaps are staged in the other one
+       and published all at once by flipBanks() : readers see all-old or all-new.
+       Readers announce the bank they use (enterRead), the previous bank is only
+       written again once they all left it (grace period, see syncBanks).
+       Without banks, staged swaps are visible immediately.
+       Return true if successful, false if memory was not big enough.            */
+    bool enableBanks     (void* alignPtr_buffer, size_t bufferSize);
+
+    /* Stage a swap : handle references on the old instance will resolve to the
+       new instance after the next flipBanks(). Direct hotswap_ptr are not touched.
+       With banks, staged swaps chain : staging A->B then B->C publishes A->C and B->C.
+       A staged swap to an object destroyed before the flip is cancelled.
+       Synchronize the inactive bank first if a flip happened since last stage. */
+    void stageSwap       (Swappable* oldInstance, Swappable* newInstance);
+
+    /* Publish all the staged swaps with a single store                          */
+    void flipBanks       ();
+
+    /* Copy the published entries back into the inactive bank, once no reader
+       uses it anymore. Return false without writing if readers are still there
+       (ie call again next frame).                                               */
+    bool trySyncBanks    ();
+
+    /* Same, waits for the readers of the previous bank to leave : they only hold
+       it for a resolve, or for a read section (enterRead/leaveRead).
+       Called automatically by the next stageSwap()/flipBanks().                 */
+    void syncBanks       ();
+
+    /* Read section : handles resolved with the returned bank all come from the
+       same flip. Any thread, keep it short, the manager thread may wait for it.
+       Return the bank to give to resolveHandle and leaveRead.                   */
+    inline
+    unsigned int enterRead   () const;
+
+    inline
+    void         leaveRead   (unsigned int bank) const;
+
+#ifndef LX_SWAPPABLE_NO_STAGING
+    /* Function for the client to know how much memory enableStaging(...) needs */
+    static
+    size_t  getStagingAllocSize(size_t SwappableMaxCount);
+
+    /* Make this manager a staging manager : objects and references can be built
+       against it on another thread (ie level loader), then moved at once into the
+       live manager with merge(). Must be called before any registration.
+       Only MAKESWAPPABLE objects, not external ones nor hotswap_handle.
+       Return true if successful, false if memory was not big enough.            */
+    bool enableStaging   (void* alignPtr_buffer, size_t bufferSize);
+
+    /* Move all the objects of a staging manager into this one, in one linear pass :
+       entries are copied to a contiguous range of never used entries and each
+       object gets its new handle. References lists are kept as is.
+       Staging manager is empty afterward and can be reused.
+       Loader thread must be done with the staging manager, this manager thread only.
+       Return false if not a staging manager or not enough never used entries.   */
+    bool merge           (SwappableManager* staging);
+#endif
+
+    /* Current owner of a handle, through the active bank.
+       Safe to call from other threads while the manager thread swaps :
+       the target is a single pointer, read with an acquire load inside a
+       read section when banks are enabled.                                     */
+    inline
+    const void* resolveHandle(SwappableIndex handle) const;
+
+    /* Same, inside a read section (enterRead)                                   */
+    inline
+    const void* resolveHandle(SwappableIndex handle, unsigned int bank) const {
+        return SwappableAtomic::loadAcquire(&m_bankList[bank][handle].m_target);
+    }
+
+#if LX_SWAPPABLE_VERSIONS > 0
+    /* Current tick, stamped on each swap. Must increase (ie frame or replay tick). */
+    void setTick        (unsigned int tick) { m_tick = tick; }
+    unsigned int
+         getTick        () const            { return m_tick; }
+#endif
+
+#ifdef LX_SWAPPABLE_PERF
+    /* Attach an instrumentation object, NULL to stop measuring.                */
+    void setPerf        (SwappablePerf* perf) { m_perf = perf; }
+#endif
 
 private:
 
@@ -137,7 +365,17 @@ private:
     //
 
     friend class Swappable;
+    friend class SwappableScheduler;
+    friend class SwappableExternal;
+    friend class SwappableSaver;
+    friend class SwappableLoader;
+    friend class SwappableReferenceSet;
+    friend class SwappableReferenceBatch;
+    friend class SwappableInPlace;
     template<class U> friend class hotswap_ptr;
+    template<class U> friend class hotswap_handle;
+    template<class U> friend class hotswap_unique_ptr;
+    template<class U> friend class hotswap_shared_ptr;
 
     /* Structure used inside each smart pointer as a link list item.            */
     struct SwappableInstance {
@@ -153,11 +391,38 @@ private:
             memory cost anyway. */
         const void* ptr;            // Real Pointer to instance of swappable object.
         SwappableInstance* next;    // Link list for next item with same pointer.
-        SwappableInstance* prev;    // Link list for previous item with same pointer.
+        SwappableInstance* prev;    // Link list for previous item with same pointer, group in the low bits.
     };
 
+    /* Group of a reference, stored in the alignment bits of prev (MAX_GROUP)     */
+    static const size_t GROUP_MASK = MAX_GROUP;
+
+    static inline SwappableInstance* getPrevLink(const SwappableInstance* wrapper) {
+        return (SwappableInstance*)((size_t)wrapper->prev & ~GROUP_MASK);
+    }
+    static inline void setPrevLink(SwappableInstance* wrapper, SwappableInstance* prev) {
+        wrapper->prev = (SwappableInstance*)(((size_t)wrapper->prev & GROUP_MASK) | (size_t)prev);
+    }
+    static inline unsigned int getGroup(const SwappableInstance* wrapper) {
+        return (unsigned int)((size_t)wrapper->prev & GROUP_MASK);
+    }
+    static inline void setGroup(SwappableInstance* wrapper, unsigned int group) {
+        wrapper->prev = (SwappableInstance*)(((size_t)wrapper->prev & ~GROUP_MASK) | (group & GROUP_MASK));
+    }
+
     /*    Internal arrays and associated allocator info.
-        Uses double link-list using arrays index on 24 bit.                      */
+        Uses double link-list using arrays index on LX_SWAPPABLE_INDEX_BITS.     */
+#if LX_SWAPPABLE_INDEX_BITS == 16
+    struct SLOTLIST {
+        // 4 Byte per entry.
+        unsigned short   m_prev;
+        unsigned short   m_next;
+    };
+    static inline SwappableIndex getPrev(const SLOTLIST& e)             { return e.m_prev; }
+    static inline SwappableIndex getNext(const SLOTLIST& e)             { return e.m_next; }
+    static inline void setPrev(SLOTLIST& e, SwappableIndex idx)         { e.m_prev = (unsigned short)idx; }
+    static inline void setNext(SLOTLIST& e, SwappableIndex idx)         { e.m_next = (unsigned short)idx; }
+#elif LX_SWAPPABLE_INDEX_BITS == 24
     struct SLOTLIST {
         // 6 Byte per entry.
         unsigned short   m_prev16;
@@ -165,55 +430,252 @@ private:
         unsigned char    m_prev8;
         unsigned char    m_next8;
     };
+    static inline SwappableIndex getPrev(const SLOTLIST& e)             { return (SwappableIndex)(e.m_prev16 | (e.m_prev8 << 16)); }
+    static inline SwappableIndex getNext(const SLOTLIST& e)             { return (SwappableIndex)(e.m_next16 | (e.m_next8 << 16)); }
+    static inline void setPrev(SLOTLIST& e, SwappableIndex idx)         { e.m_prev16 = (unsigned short)idx; e.m_prev8 = (unsigned char)(idx >> 16); }
+    static inline void setNext(SLOTLIST& e, SwappableIndex idx)         { e.m_next16 = (unsigned short)idx; e.m_next8 = (unsigned char)(idx >> 16); }
+#elif LX_SWAPPABLE_INDEX_BITS == 32
+    struct SLOTLIST {
+        // 8 Byte per entry, aligned.
+        unsigned int     m_prev;
+        unsigned int     m_next;
+    };
+    static inline SwappableIndex getPrev(const SLOTLIST& e)             { return e.m_prev; }
+    static inline SwappableIndex getNext(const SLOTLIST& e)             { return e.m_next; }
+    static inline void setPrev(SLOTLIST& e, SwappableIndex idx)         { e.m_prev = idx; }
+    static inline void setNext(SLOTLIST& e, SwappableIndex idx)         { e.m_next = idx; }
+#else
+    struct SLOTLIST {
+        // 12 Byte per entry.
+        unsigned int     m_prev32;
+        unsigned int     m_next32;
+        unsigned short   m_prev16;
+        unsigned short   m_next16;
+    };
+    static inline SwappableIndex getPrev(const SLOTLIST& e)             { return e.m_prev32 | ((SwappableIndex)e.m_prev16 << 32); }
+    static inline SwappableIndex getNext(const SLOTLIST& e)             { return e.m_next32 | ((SwappableIndex)e.m_next16 << 32); }
+    static inline void setPrev(SLOTLIST& e, SwappableIndex idx)         { e.m_prev32 = (unsigned int)idx; e.m_prev16 = (unsigned short)(idx >> 32); }
+    static inline void setNext(SLOTLIST& e, SwappableIndex idx)         { e.m_next32 = (unsigned int)idx; e.m_next16 = (unsigned short)(idx >> 32); }
+#endif
+
+#if LX_SWAPPABLE_VERSIONS > 0
+    /*    Previous owner of an entry and the tick it became current              */
+    struct VERSION {
+        const void*           m_owner;                   // Previous owner, NULL if unused.
+        unsigned int          m_since;                   // Tick when it became current.
+    };
+#endif
 
     /*    Information stored for each entry inside the manager                   */
     struct ITEM {
-        Swappable*            m_item;                    // Pointer to the registered swappable.
+        const void*           m_owner;                   // Registered owner (object using MAKESWAPPABLE).
         SwappableInstance*    m_linkList;                // Pointer to the link list of references.
+        const void*           m_target;                  // Owner handles resolve to : registered owner, or the one staged in its place.
+        SwappableIndex        m_forward;                 // Entry which replaced this one, NULL_IDX if current.
+        unsigned int          m_forwardGen;              // Generation of the forward entry when set : stale once it is freed.
+        unsigned int          m_forwardIn;               // Entries forwarding to this one.
+        unsigned int          m_generation;              // Bumped each time the entry is freed.
+        unsigned int          m_shared;                  // Owning references (hotswap_shared_ptr), moved with the references on swaps.
+#if LX_SWAPPABLE_VERSIONS > 0
+        unsigned int          m_since;                   // Tick when current owner became current.
+        unsigned int          m_versionHead;             // Next ring entry to write.
+        VERSION               m_versions[LX_SWAPPABLE_VERSIONS]; // Ring of previous owners.
+#endif
     };
 
     /* All array and variable for the manager                                    */
     ITEM*               m_arrayList;                     // List of registered swappable object.
     SLOTLIST*           m_allocList;                     // Link list of registered swappable and free slot.
-    unsigned int        m_freeSwappable;                 // Number of available free swappable object.
-    unsigned int        m_totalSwappable;                // Total number of swappable object we can register.
-    unsigned int        m_usedIdxSwappable;              // Head to list of registered swappable object.
-    unsigned int        m_freeIdxSwappable;              // Head to list of freely available object.
+    SwappableIndex      m_freeSwappable;                 // Number of available free swappable object.
+    SwappableIndex      m_totalSwappable;                // Total number of swappable object we can register.
+    SwappableIndex      m_usedIdxSwappable;              // Head to list of registered swappable object.
+    SwappableIndex      m_freeIdxSwappable;              // Head to list of freely available object.
+    SwappableIndex      m_highWater;                     // Entries from here were never used, allocated after the free list.
+    Swappable**         m_trackerList;                   // Swappable of each entry for staging managers, NULL otherwise.
+#if LX_SWAPPABLE_VERSIONS > 0
+    unsigned int        m_tick;                          // Current tick for versioning.
+#endif
+    ITEM*               m_bankList[2];                   // Tables for handle resolution, both m_arrayList when banks are disabled.
+    unsigned int        m_activeBank;                    // Bank used by readers (0 or 1).
+    mutable unsigned int m_readers[2];                   // Readers inside each bank.
+    SwappableIndex*     m_stagedList;                    // Link list of entries staged in the inactive bank, STAGED_NONE if not staged.
+    SwappableIndex      m_stagedIdxSwappable;            // Head to list of staged entries.
+    bool                m_syncPending;                   // Inactive bank is late of one flip.
+    SwappableRetireFunc m_retireHandler;                 // Optional retire handler.
+    void*               m_retireContext;                 // Context given to the retire handler.
+    SwapRequest*        m_pendingHead;                   // First queued swap.
+    SwapRequest*        m_pendingTail;                   // Last queued swap.
+#ifdef LX_SWAPPABLE_PERF
+    SwappablePerf*      m_perf;                          // Optional instrumentation.
+#endif
+
+#ifdef LX_SWAPPABLE_COMPACT
+#if LX_SWAPPABLE_INDEX_BITS == 32
+    /* Compact Swappable : no spare bit above a 32 bit slot, single manager     */
+    static const unsigned int    MAX_MANAGERS     = 1;
+#else
+    /* Compact Swappable : handle stores the manager id above the slot index     */
+    static const unsigned int    HANDLE_SLOT_BITS = (LX_SWAPPABLE_INDEX_BITS == 48) ? 48 : 24;
+    static const SwappableIndex  HANDLE_SLOT_MASK = ((SwappableIndex)1 << HANDLE_SLOT_BITS) - 1;
+    static const unsigned int    MAX_MANAGERS     = 256;
+#endif
+
+    static SwappableManager*     s_registry[MAX_MANAGERS]; // Managers by id, claimed atomically by init().
+    unsigned int        m_registryId;                    // Id of this manager inside s_registry.
+#endif
 
     /* Internal null constant for array index link list                          */
-    static const unsigned int    NULL_IDX    = 0x00FFFFFF;    // 24 bit null
-    static const unsigned short    NULL_IDX16    = 0xFFFF;    // 16 bit part null
-    static const unsigned char    NULL_IDX8    = 0xFF;        //  8 bit part null
+    static const SwappableIndex  NULL_IDX    = (SwappableIndex)(((unsigned long long)1 << LX_SWAPPABLE_INDEX_BITS) - 1); // All index bits set
+    static const SwappableIndex  STAGED_NONE = NULL_IDX - 1;  // Entry not staged
+
+    /* Publish a new target for an entry : a single aligned pointer store, handle
+       readers load it with acquire and see the whole new object.              */
+    inline
+    void writeItem            (ITEM& item, const void* target) {
+        SwappableAtomic::storeRelease(&item.m_target, target);
+    }
 
     /* Remove swappable entry                                                    */
-    void freeSwappable        (unsigned int handle);
+    void freeSwappable        (SwappableIndex handle);
+
+    /* Cancel the staged swaps of a freed entry and the ones targeting its owner */
+    void unstageSwappable     (SwappableIndex handle, const void* owner);
 
     /* Allocate swappable entry                                                  */
-    unsigned int
-         allocateSwappable    (Swappable* pTracker);
+    SwappableIndex
+         allocateSwappable    (const void* owner);
 
     /* Connect a reference at the beginning of the references link list          */
     inline
-    void addListStart         (SwappableInstance* wrapper, unsigned int handle) {
+    void addListStart         (SwappableInstance* wrapper, SwappableIndex handle) {
         SwappableInstance* prevHead = m_arrayList[handle].m_linkList;
         if (prevHead) {
-            prevHead->prev = wrapper;
+            setPrevLink(prevHead, wrapper);
         }
         wrapper->next = prevHead;
-        wrapper->prev = 0;
+        setPrevLink(wrapper, 0);
 
         m_arrayList[handle].m_linkList = wrapper;
     }
 
+    /* Connect an already chained run of references [first..last] at the beginning
+       of the references link list : one head update for the whole run.          */
+    inline
+    void spliceListStart      (SwappableInstance* first, SwappableInstance* last, SwappableIndex handle) {
+        SwappableInstance* prevHead = m_arrayList[handle].m_linkList;
+        if (prevHead) {
+            setPrevLink(prevHead, last);
+        }
+        last->next = prevHead;
+        setPrevLink(first, 0);
+
+        m_arrayList[handle].m_linkList = first;
+    }
+
     /* Remove a reference at the beginning of the references link list           */
     inline
-    void removeListStart      (SwappableInstance* wrapper, unsigned int handle) {
+    void removeListStart      (SwappableInstance* wrapper, SwappableIndex handle) {
         // Remove just first item and put new one.
         m_arrayList[handle].m_linkList = wrapper->next;
     }
 
-    /* Remove a reference at the beginning of the references link list           */
+    /* Remove a reference from any place of the references link list            */
+    inline
+    void removeReference      (SwappableInstance* wrapper, SwappableIndex handle) {
+        SwappableInstance* prev = getPrevLink(wrapper);
+        if (prev == 0) {
+            // Remove from the beginning of the link list.
+            removeListStart(wrapper, handle);
+        } else {
+            // Remove from the middle place of the link list.
+            prev->next = wrapper->next;
+        }
+
+        if (wrapper->next) {
+            setPrevLink(wrapper->next, prev);
+        }
+    }
+
+    /* Move the references accepted by the filter, single walk                   */
+    size_t moveFiltered       (SwappableIndex handleOld, SwappableIndex handleNew, ReferenceFilter filter, void* context);
+
+    static
+    bool groupFilter          (void* context, const void* reference);
+
+    /* Move all references of the old instance to the new instance              */
     void replaceObject        (Swappable* oldInstance, Swappable* newInstance);
+
+    /* Owning references count of an entry                                       */
+    inline
+    void acquireShared        (SwappableIndex handle) {
+        m_arrayList[handle].m_shared++;
+    }
+
+    /* Return the number of owning references left                               */
+    inline
+    unsigned int
+         releaseShared        (SwappableIndex handle) {
+        return --m_arrayList[handle].m_shared;
+    }
+
+    /* Same, from the entries                                                    */
+    void replaceSlot          (SwappableIndex handleOld, SwappableIndex handleNew);
+
+    /* Record that old entry was replaced by the new one, for checked accesses  */
+    void setForward           (SwappableIndex handleOld, SwappableIndex handleNew);
+
+    /* Entry is current again                                                    */
+    void clearForward         (SwappableIndex handle);
+
+    /* Entry the references of an entry forward to, NULL_IDX if current or if
+       the forward entry was freed since (it may hold an unrelated object now).  */
+    inline
+    SwappableIndex
+         getForward           (SwappableIndex handle) const {
+        SwappableIndex target = m_arrayList[handle].m_forward;
+        if ((target != NULL_IDX) && (m_arrayList[target].m_generation == m_arrayList[handle].m_forwardGen)) {
+            return target;
+        }
+        return NULL_IDX;
+    }
+
+    /* Tell if the forward chain starting at an entry goes through another one  */
+    bool forwardsTo           (SwappableIndex handle, SwappableIndex target) const;
+
+    /* Keep track of the old owner in the new entry history (LX_SWAPPABLE_VERSIONS) */
+    void pushVersion          (SwappableIndex handleOld, SwappableIndex handleNew);
+
+    /* Tell if the references of an entry forward to another one                */
+    inline
+    bool isForwarded          (SwappableIndex handle) const {
+        return SwappableAtomic::loadAcquire(&m_arrayList[handle].m_forward) != NULL_IDX;
+    }
+
+    /* Move a reference of a forwarded entry to the end of the forward chain.
+       The reference stays if the forward entry was freed since.
+       Return the new owner.                                                     */
+    const void*
+         healReference        (SwappableInstance* wrapper, SwappableIndex handle);
+
+#if LX_SWAPPABLE_VERSIONS > 0
+    /* Owner of the entry which was current at the given tick, NULL if too old.
+       Ring is small and fixed : constant time.                                  */
+    const void*
+         getOwnerAtTick       (SwappableIndex handle, unsigned int tick) const;
+#endif
+};
+
+/* Constructor tag for swapInPlace : carries the registration of the previous
+   version to the Swappable of the new one.                                      */
+class SwappableInPlace {
+    friend class Swappable;
+public:
+    /* Take the registration of the previous version, left unregistered        */
+    inline explicit
+    SwappableInPlace(Swappable& previous);
+private:
+    SwappableManager*    m_mgr;
+    SwappableIndex       m_handle;
 };
 
 /*  ====================================================================================
@@ -222,46 +684,56 @@ private:
     ==================================================================================== */
 class Swappable {
     template<class U> friend class hotswap_ptr;
+    template<class U> friend class hotswap_handle;
     friend class SwappableManager;
+    friend class SwappableInPlace;
 public:
-    /* Swappable stores pointer to the manager and reference to the original object.
+    /* Swappable registers the original object in the manager, which keeps the owner pointer.
        It will receive a allocated handle in exchange */
     Swappable(void* obj, SwappableManager* mgr)
     {
-        m_owner            = obj;
-        m_mgr            = mgr;
-        registerObject(this);
+        registerObject(obj, mgr);
+    }
+
+    /* Rebuilt in place (swapInPlace) : takes the registration of the previous version */
+    Swappable(const SwappableInPlace& tag)
+    {
+        setHandle(tag.m_mgr, tag.m_handle);
+        if (tag.m_mgr->m_trackerList && (tag.m_handle != SwappableManager::NULL_IDX)) {
+            tag.m_mgr->m_trackerList[tag.m_handle] = this;
+        }
     }
 
     /* When Swappable is destroyed, ie when a swappable class dies (because it is a member)
        Call the manager to unregister the pointer */
     ~Swappable() {
-        unregisterObject(this);
+        unregisterObject();
     }
 
+#if defined(LX_SWAPPABLE_COMPACT) && (LX_SWAPPABLE_INDEX_BITS == 32)
+    /* Single manager, handle is the slot                                        */
+    inline SwappableManager* getManager() const { return SwappableManager::s_registry[0]; }
+    inline SwappableIndex    getSlot   () const { return m_handle; }
+#elif defined(LX_SWAPPABLE_COMPACT)
+    /* Manager is found from the handle bits                                     */
+    inline SwappableManager* getManager() const { return SwappableManager::s_registry[m_handle >> SwappableManager::HANDLE_SLOT_BITS]; }
+    inline SwappableIndex    getSlot   () const { return m_handle & SwappableManager::HANDLE_SLOT_MASK;  }
+#else
+    inline SwappableManager* getManager() const { return m_mgr;    }
+    inline SwappableIndex    getSlot   () const { return m_handle; }
+#endif
+
     inline
     void _SwappableReset      (SwappableManager::SwappableInstance* wrapper) {
-        //
         // Remove item from link list
-        //
-
-        if (wrapper->prev == 0) {
-            // Remove from the beginning of the link list.
-            this->m_mgr->removeListStart(wrapper, m_handle);
-        } else {
-            // Remove from the middle place of the link list.
-            wrapper->prev->next = wrapper->next;
-        }
-
-        if (wrapper->next) {
-            wrapper->next->prev = wrapper->prev;
-        }
+        getManager()->removeReference(wrapper, getSlot());
     }
 
     inline
     void _SwappableWrite      (SwappableManager::SwappableInstance* wrapper) {
+        LX_SWAPPABLE_PERF_SCOPE(getManager(), OP_ATTACH_REFERENCE);
         // Add item to link list
-        m_mgr->addListStart(wrapper, m_handle);
+        getManager()->addListStart(wrapper, getSlot());
     }
 private:
 
@@ -272,12 +744,28 @@ private:
     //
 
     // Tracker registration
-    void registerObject       (Swappable* tracker);
-    void unregisterObject     (Swappable* tracker);
+    void registerObject       (void* obj, SwappableManager* mgr);
+    void unregisterObject     ();
+
+    inline
+    void setHandle            (SwappableManager* mgr, SwappableIndex handle) {
+#if defined(LX_SWAPPABLE_COMPACT) && (LX_SWAPPABLE_INDEX_BITS == 32)
+        (void)mgr;
+        m_handle = handle;
+#elif defined(LX_SWAPPABLE_COMPACT)
+        m_handle = ((SwappableIndex)mgr->m_registryId << SwappableManager::HANDLE_SLOT_BITS) | handle;
+#else
+        m_mgr    = mgr;
+        m_handle = handle;
+#endif
+    }
 
+#ifdef LX_SWAPPABLE_COMPACT
+    SwappableIndex       m_handle;                       // Manager id in the top bits, slot in the others.
+#else
     SwappableManager*    m_mgr;
-    void*                m_owner;
-    unsigned int         m_handle;
+    SwappableIndex       m_handle;
+#endif
 
     // Force object to be a member or alloc on stack only.
     void *operator    new      ( size_t );
@@ -287,12 +775,176 @@ private:
 };
 
 
+inline
+SwappableInPlace::SwappableInPlace(Swappable& previous)
+:m_mgr      (previous.getManager())
+,m_handle   (previous.getSlot())
+{
+    previous.setHandle(m_mgr, SwappableManager::NULL_IDX);
+}
+
+inline
+unsigned int SwappableManager::enterRead() const {
+    for (;;) {
+        unsigned int bank = SwappableAtomic::loadAcquire(&m_activeBank);
+        SwappableAtomic::fetchAdd(&m_readers[bank], 1u);
+        // Pairs with the fence of trySyncBanks : either the manager sees this
+        // reader, or this reader sees the flip.
+        SwappableAtomic::fence();
+        if (SwappableAtomic::loadRelaxed(&m_activeBank) == bank) {
+            return bank;
+        }
+        // Flipped meanwhile, the bank may be written : go to the new one.
+        SwappableAtomic::fetchAdd(&m_readers[bank], (unsigned int)-1);
+    }
+}
+
+inline
+void SwappableManager::leaveRead(unsigned int bank) const {
+    SwappableAtomic::fetchAdd(&m_readers[bank], (unsigned int)-1);
+}
+
+inline
+const void* SwappableManager::resolveHandle(SwappableIndex handle) const {
+    if (m_stagedList == 0) {
+        // Banks disabled : single table, written in place.
+        return SwappableAtomic::loadAcquire(&m_arrayList[handle].m_target);
+    }
+
+    unsigned int bank  = enterRead();
+    const void*  owner = resolveHandle(handle, bank);
+    leaveRead(bank);
+    return owner;
+}
+
 // Public OR friend, so macros is public.
 #define MAKESWAPPABLE(className)  \
 public:\
+    typedef className _SwappableOwner;\
     lx::Swappable _trackMe;\
 private:\
 
+// Layout of the data members, identical for versions which can be swapped in place.
+#define SWAPPABLE_LAYOUT(layoutHash)  \
+public:\
+    static const unsigned int _SwappableLayout = (layoutHash);\
+private:\
+
+
+/*  ====================================================================================
+        Conversion between a pointer and the owner registered in its Swappable,
+        ie the class using MAKESWAPPABLE. References store the owner pointer because
+        it is what the manager writes on swaps : the pointer adjustment for a class
+        deriving from the owner (multiple inheritance) is known at compile time and
+        applied when using the pointer. Nothing is stored per reference, and with
+        single inheritance the conversion is free.
+        Scope :
+        - T is the owner or derives from it. A reference on another base of the
+          object (one without MAKESWAPPABLE) is a hotswap_ptr< swappable_base<T> >.
+        - fromOwner is an unchecked downcast : the object swapped in must be a T too,
+          swapping a reference on a derived class to a sibling class is undefined.
+        - A virtual base owner is rejected by the compiler (no static downcast).
+    ====================================================================================*/
+template < typename T >
+struct SwappableCast {
+    typedef typename T::_SwappableOwner Owner;
+
+    static inline const void* toOwner   (const T* ptr)      { return (const void*)static_cast<const Owner*>(ptr); }
+    static inline T*          fromOwner (const void* owner) { return static_cast<T*>((Owner*)owner);              }
+    static inline Swappable&  tracker   (const void* owner) { return ((Owner*)owner)->_trackMe;                   }
+};
+
+
+template<class T>
+void SwappableManager::destroyObject(void* object) {
+    delete SwappableCast<T>::fromOwner(object);
+}
+
+/*  ====================================================================================
+        In-place swap for versions with the same data layout : the object is rebuilt
+        as the new version in its own memory, so references are not touched and the
+        cost does not depend on their count.
+
+        The previous version is copied aside (copy constructor), destroyed, then the
+        new version is constructed in place from the copy, which is destroyed last.
+        Each step is a regular constructor or destructor call : the state kept
+        does not depend on the optimization level.
+
+        Both versions declare SWAPPABLE_LAYOUT with the same hash (ie bumped by hand or
+        generated from the field list), size and alignment must match : checked at
+        compile time. The new version provides a constructor taking the previous
+        version and the SwappableInPlace tag : it copies the state it keeps and passes
+        the tag to _trackMe, which takes over the registration.
+
+        class EnemyV2 : public Actor {              // Actor is the MAKESWAPPABLE owner.
+            SWAPPABLE_LAYOUT(0x5E1A)
+        public:
+            EnemyV2(const Enemy& previous, const SwappableInPlace& tag)
+            :Actor(previous, tag)                   // Actor passes the tag to _trackMe.
+            ,m_hp (previous.m_hp)
+            {
+            }
+            virtual void update();
+        };
+
+        EnemyV2* enemy = swapInPlace<EnemyV2>(oldEnemy);
+
+        The copy lives on the stack during the swap. Old version must be the real
+        type of the object (the destructor called is From's).
+        Return NULL if the owner is not at the same place in both versions.
+        Objects used by other threads must be protected by the user.
+    ====================================================================================*/
+template<bool Condition>
+struct SwappableCompileCheck;
+
+template<>
+struct SwappableCompileCheck<true> {
+    enum { OK = 1 };
+};
+
+template < typename T >
+struct SwappableAlignOf {
+    struct Probe { char c; T t; };
+    enum { VALUE = sizeof(Probe) - sizeof(T) };
+};
+
+/* Stack storage for an object built with placement new                         */
+template < typename T >
+struct SwappableStorage {
+    union {
+        unsigned char   m_bytes[sizeof(T)];
+        long double     m_alignFloat;
+        long long       m_alignInteger;
+        void*           m_alignPointer;
+    };
+};
+
+template < typename To, typename From >
+To* swapInPlace(From* obj) {
+    enum {
+        SAME_SIZE   = SwappableCompileCheck<sizeof(To) == sizeof(From)>::OK,
+        SAME_ALIGN  = SwappableCompileCheck<(int)SwappableAlignOf<To>::VALUE == (int)SwappableAlignOf<From>::VALUE>::OK,
+        SAME_LAYOUT = SwappableCompileCheck<To::_SwappableLayout == From::_SwappableLayout>::OK,
+        FIT_STORAGE = SwappableCompileCheck<(int)SwappableAlignOf<From>::VALUE <= (int)SwappableAlignOf< SwappableStorage<From> >::VALUE>::OK
+    };
+
+    // References store the owner pointer : it must not move.
+    const unsigned char* probe = (const unsigned char*)obj;
+    if ((const unsigned char*)SwappableCast<To  >::toOwner((const To*  )probe) - probe
+     != (const unsigned char*)SwappableCast<From>::toOwner((const From*)probe) - probe) {
+        return 0;
+    }
+
+    // Registration goes to the new version, the old one and its copy do not unregister.
+    SwappableInPlace tag(SwappableCast<From>::tracker(SwappableCast<From>::toOwner(obj)));
+
+    SwappableStorage<From> storage;
+    From* previous = new ((void*)storage.m_bytes) From(*obj);
+    obj->~From();
+    To* swapped    = new ((void*)obj) To(*previous, tag);
+    previous->~From();
+    return swapped;
+}
 
 /*  ====================================================================================
         Smart pointer like template, no overhead when using the pointer.
@@ -300,6 +952,13 @@ private:\
 template < typename T >
 class hotswap_ptr {
     friend class Swappable;
+    friend class SwappableHazard;
+    friend class SwappableSaver;
+    friend class SwappableReferenceSet;
+    template<class U> friend class hotswap_unique_ptr;
+    template<class U> friend class hotswap_shared_ptr;
+    template<class U> friend class hotswap_atomic_ptr;
+    template<class U> friend class hotswap_fn;
 private:
     SwappableManager::SwappableInstance instance;
 
@@ -309,17 +968,20 @@ private:
     void *operator   new[]    ( size_t );
     void operator    delete[] ( void*  );
 
-    void update(const T* ptr) {
+    typedef SwappableCast<T> Cast;
+
+    /* Reference stores the owner pointer, as patched by the manager on swaps.  */
+    void update(const void* owner) {
         // Optimize updates
-        if (ptr != instance.ptr) {
+        if (owner != instance.ptr) {
             if (instance.ptr) {
-                ((T*)instance.ptr)->_trackMe._SwappableReset(&instance);
+                Cast::tracker(instance.ptr)._SwappableReset(&instance);
             }
 
-            instance.ptr = (const void*)ptr;
+            SwappableAtomic::storeRelease(&instance.ptr, owner);
 
-            if (ptr) {
-                ((T*)instance.ptr)->_trackMe._SwappableWrite(&instance);
+            if (owner) {
+                Cast::tracker(owner)._SwappableWrite(&instance);
             }
         }
     }
@@ -331,24 +993,65 @@ public:
     hotswap_ptr(T* pValue)
     {
         if (pValue) {
-            instance.ptr = pValue;
-            pValue->_trackMe._SwappableWrite(&instance,(void*)pValue);
+            instance.ptr = Cast::toOwner(pValue);
+            pValue->_trackMe._SwappableWrite(&instance);
         }
     }
 
+    // Copy is a new reference in the list, not a copy of the links.
+    hotswap_ptr(const hotswap_ptr<T>& sp)
+    {
+        update(sp.instance.ptr);
+    }
+
     ~hotswap_ptr()
     {
-        ((T*)instance.ptr)->_trackMe._SwappableReset(&instance);
+        if (instance.ptr) {
+            Cast::tracker(instance.ptr)._SwappableReset(&instance);
+        }
     }
 
     T& operator* ()
     {
-        return *((T*)(instance.ptr));
+        return *Cast::fromOwner(instance.ptr);
     }
 
     T* operator-> ()
     {
-        return (T*)(instance.ptr);
+        return Cast::fromOwner(instance.ptr);
+    }
+
+    /* Checked access : if the object was swapped lazily (forwardObject) or the
+       incremental swap did not reach this reference yet, the reference moves
+       itself to the new object. Costs a lookup in the manager, operator-> stays free.
+       Modify the reference lists : thread owning the manager only.             */
+    T* resolve ()
+    {
+        if (instance.ptr) {
+            Swappable& tracker = Cast::tracker(instance.ptr);
+            SwappableManager* mgr = tracker.getManager();
+            if (mgr->isForwarded(tracker.getSlot())) {
+                return Cast::fromOwner(mgr->healReference(&instance, tracker.getSlot()));
+            }
+        }
+        return Cast::fromOwner(instance.ptr);
+    }
+
+    /* Tag the reference for selective swaps (SwappableManager::replaceGroup),
+       0 by default. Kept by assignments, not copied.
+       Return false if group is above SwappableManager::MAX_GROUP (unchanged).  */
+    bool setGroup(unsigned int group)
+    {
+        if (group > SwappableManager::MAX_GROUP) {
+            return false;
+        }
+        SwappableManager::setGroup(&instance, group);
+        return true;
+    }
+
+    unsigned int getGroup() const
+    {
+        return SwappableManager::getGroup(&instance);
     }
 
     hotswap_ptr<T>& operator = (const hotswap_ptr<T>& sp)
@@ -361,17 +1064,13 @@ public:
 
     hotswap_ptr<T>& operator = (const T* obj)
     {
-        if (this->instance.ptr != obj) {
-            update(obj);
-        }
+        update(Cast::toOwner(obj));
         return *this;
     }
 
     hotswap_ptr<T>& operator = (T* obj)
     {
-        if (this->instance.ptr != obj) {
-            update(obj);
-        }
+        update(Cast::toOwner(obj));
         return *this;
     }
 
@@ -404,12 +1103,192 @@ public:
         return *this;
     }
 
+#if LX_SWAPPABLE_VERSIONS > 0
+    /* Object which was referenced at the given tick, following previous swaps.
+       Return NULL if the tick is older than the versions kept, or if NULL.
+       Previous versions are NOT kept alive : user must delay their destruction. */
+    T* atTick(unsigned int tick) const {
+        if (instance.ptr) {
+            const Swappable& tracker = Cast::tracker(instance.ptr);
+            return Cast::fromOwner(tracker.getManager()->getOwnerAtTick(tracker.getSlot(), tick));
+        }
+        return 0;
+    }
+#endif
+
     /* Hotswap from any place all user of the same pointer.
        Return false if current object is NULL or if new object is NULL.*/
     bool hotSwapTo(T* obj) {
         if (this->instance.ptr && obj) {
-            T* a = (T*)this->instance.ptr;
-            a->_trackMe.m_mgr->replaceObject(&a->_trackMe, &obj->_trackMe);
+            Swappable& a = Cast::tracker(this->instance.ptr);
+            a.getManager()->replaceObject(&a, &obj->_trackMe);
+            return true;
+        } else {
+            return false;
+        }
+    }
+};
+
+/* Tag to reference an object through a base class which is not its owner     */
+template < typename T >
+struct swappable_base {
+};
+
+/* Conversion from the owner to the base T, for one class deriving from both    */
+template < typename T >
+struct SwappableBaseCast {
+    T*          (*m_fromOwner)  (const void* owner);
+    Swappable&  (*m_tracker)    (const void* owner);
+};
+
+template < typename D, typename T >
+struct SwappableBaseCastOf {
+    static T*         fromOwner (const void* owner) { return static_cast<T*>(SwappableCast<D>::fromOwner(owner)); }
+    static Swappable& tracker   (const void* owner) { return SwappableCast<D>::tracker(owner);                   }
+
+    static const SwappableBaseCast<T> s_cast;
+};
+
+template < typename D, typename T >
+const SwappableBaseCast<T> SwappableBaseCastOf<D,T>::s_cast = {
+    &SwappableBaseCastOf<D,T>::fromOwner,
+    &SwappableBaseCastOf<D,T>::tracker
+};
+
+/*  ====================================================================================
+        Reference on an object through a base class which is not the owner, ie the
+        second base of a class deriving from the MAKESWAPPABLE owner :
+
+        class Player : public Actor, public Listener { ... };   // Actor is the owner.
+        hotswap_ptr< swappable_base<Listener> > listener = player;
+
+        The base can not be reached from the owner at compile time : the reference
+        keeps the conversion of the class it was assigned from, one pointer more than
+        a plain hotswap_ptr and an indirect call on use. Other references pay nothing.
+        The object swapped in must be of the same class : checked by hotSwapTo,
+        swaps done by other references must keep it too.
+    ====================================================================================*/
+template < typename T >
+class hotswap_ptr< swappable_base<T> > {
+private:
+    SwappableManager::SwappableInstance instance;
+    const SwappableBaseCast<T>*         m_cast;         // Conversion of the object referenced.
+
+    // Force object to be a member or alloc on stack only.
+    void *operator   new      ( size_t );
+    void operator    delete   ( void*  );
+    void *operator   new[]    ( size_t );
+    void operator    delete[] ( void*  );
+
+    void update(const void* owner, const SwappableBaseCast<T>* cast) {
+        if (owner != instance.ptr) {
+            if (instance.ptr) {
+                m_cast->m_tracker(instance.ptr)._SwappableReset(&instance);
+            }
+
+            SwappableAtomic::storeRelease(&instance.ptr, owner);
+
+            if (owner) {
+                cast->m_tracker(owner)._SwappableWrite(&instance);
+            }
+        }
+        m_cast = cast;
+    }
+public:
+    hotswap_ptr()
+    :m_cast(0)
+    {
+    }
+
+    template<class D>
+    hotswap_ptr(D* pValue)
+    :m_cast(0)
+    {
+        if (pValue) {
+            update(SwappableCast<D>::toOwner(pValue), &SwappableBaseCastOf<D,T>::s_cast);
+        }
+    }
+
+    // Copy is a new reference in the list, not a copy of the links.
+    hotswap_ptr(const hotswap_ptr< swappable_base<T> >& sp)
+    :m_cast(0)
+    {
+        update(sp.instance.ptr, sp.m_cast);
+    }
+
+    ~hotswap_ptr()
+    {
+        if (instance.ptr) {
+            m_cast->m_tracker(instance.ptr)._SwappableReset(&instance);
+        }
+    }
+
+    T& operator* () const
+    {
+        return *m_cast->m_fromOwner(instance.ptr);
+    }
+
+    T* operator-> () const
+    {
+        return instance.ptr ? m_cast->m_fromOwner(instance.ptr) : 0;
+    }
+
+    T* get() const
+    {
+        return instance.ptr ? m_cast->m_fromOwner(instance.ptr) : 0;
+    }
+
+    /* Checked access, see hotswap_ptr::resolve                                  */
+    T* resolve ()
+    {
+        if (instance.ptr) {
+            Swappable& tracker = m_cast->m_tracker(instance.ptr);
+            SwappableManager* mgr = tracker.getManager();
+            if (mgr->isForwarded(tracker.getSlot())) {
+                return m_cast->m_fromOwner(mgr->healReference(&instance, tracker.getSlot()));
+            }
+            return m_cast->m_fromOwner(instance.ptr);
+        }
+        return 0;
+    }
+
+    hotswap_ptr< swappable_base<T> >& operator = (const hotswap_ptr< swappable_base<T> >& sp)
+    {
+        if (this != &sp) {
+            update(sp.instance.ptr, sp.m_cast);
+        }
+        return *this;
+    }
+
+    template<class D>
+    hotswap_ptr< swappable_base<T> >& operator = (D* obj)
+    {
+        if (obj) {
+            update(SwappableCast<D>::toOwner(obj), &SwappableBaseCastOf<D,T>::s_cast);
+        } else {
+            update(0, 0);
+        }
+        return *this;
+    }
+
+    // Support for NULL, it can't be helped.
+    hotswap_ptr< swappable_base<T> >& operator = (int obj)
+    {
+        if (obj == 0) {
+            update(0, 0);
+        }
+        return *this;
+    }
+
+    /* Hotswap from any place all user of the same pointer.
+       Return false if current object is NULL, if new object is NULL or if it is
+       not of the class of the current one (the conversion would not hold).      */
+    template<class D>
+    bool hotSwapTo(D* obj) {
+        // Descriptors merged by identical code folding convert the same way.
+        if (this->instance.ptr && obj && (m_cast == &SwappableBaseCastOf<D,T>::s_cast)) {
+            Swappable& a = m_cast->m_tracker(this->instance.ptr);
+            a.getManager()->replaceObject(&a, &obj->_trackMe);
             return true;
         } else {
             return false;
@@ -417,6 +1296,352 @@ public:
     }
 };
 
+/*  ====================================================================================
+        Reference read from other threads while the manager thread swaps.
+        The manager publishes with release stores, the read is an acquire load
+        (a plain load on x86). Assignments and swaps stay on the manager thread.
+        Old object must outlive the readers : retire it (ie SwappableHazard).
+    ====================================================================================*/
+template < typename T >
+class hotswap_atomic_ptr {
+    friend class SwappableHazard;
+private:
+    hotswap_ptr<T>      m_ref;
+
+    typedef SwappableCast<T> Cast;
+public:
+    hotswap_atomic_ptr()
+    {
+    }
+
+    hotswap_atomic_ptr(T* pValue)
+    :m_ref(pValue)
+    {
+    }
+
+    hotswap_atomic_ptr(const hotswap_atomic_ptr<T>& sp)
+    {
+        m_ref = sp.m_ref;
+    }
+
+    T& operator* () const
+    {
+        return *get();
+    }
+
+    T* operator-> () const
+    {
+        return get();
+    }
+
+    /* Any thread                                                                */
+    T* get() const
+    {
+        return Cast::fromOwner(SwappableAtomic::loadAcquire(&m_ref.instance.ptr));
+    }
+
+    hotswap_atomic_ptr<T>& operator = (const hotswap_atomic_ptr<T>& sp)
+    {
+        if (this != &sp) {
+            m_ref = sp.m_ref;
+        }
+        return *this;
+    }
+
+    hotswap_atomic_ptr<T>& operator = (T* obj)
+    {
+        m_ref = obj;
+        return *this;
+    }
+
+    // Support for NULL, it can't be helped.
+    hotswap_atomic_ptr<T>& operator = (int obj)
+    {
+        m_ref = obj;
+        return *this;
+    }
+
+    /* Hotswap from any place all user of the same pointer. Manager thread only. */
+    bool hotSwapTo(T* obj) {
+        return m_ref.hotSwapTo(obj);
+    }
+};
+
+/*  ====================================================================================
+        Owning reference : the object is destroyed when replaced or when the owner dies.
+        Destruction goes through the manager retire path (SwappableManager::retire),
+        so it can be deferred and batched (ie SwappableRetireQueue, SwappableHazard).
+        Other hotswap_ptr on the object are plain references.
+        Object must be allocated with new, destroyed with SwappableManager::destroyObject.
+    ====================================================================================*/
+template < typename T >
+class hotswap_unique_ptr {
+private:
+    hotswap_ptr<T>      m_ref;
+
+    // Single owner : no copy.
+    hotswap_unique_ptr                      (const hotswap_unique_ptr<T>&);
+    hotswap_unique_ptr<T>& operator =       (const hotswap_unique_ptr<T>&);
+
+    typedef SwappableCast<T> Cast;
+public:
+    hotswap_unique_ptr()
+    {
+    }
+
+    explicit hotswap_unique_ptr(T* pValue)
+    :m_ref(pValue)
+    {
+    }
+
+    ~hotswap_unique_ptr()
+    {
+        reset(0);
+    }
+
+    T& operator* () const
+    {
+        return *get();
+    }
+
+    T* operator-> () const
+    {
+        return get();
+    }
+
+    T* get() const
+    {
+        return Cast::fromOwner(m_ref.instance.ptr);
+    }
+
+    /* Stop owning the object and give it back to the caller                    */
+    T* release()
+    {
+        T* obj = get();
+        m_ref  = 0;
+        return obj;
+    }
+
+    /* Retire the owned object and own the new one (can be NULL).
+       Remaining references on the old object are NOT moved : see hotSwapTo.   */
+    void reset(T* obj)
+    {
+        const void* owner = m_ref.instance.ptr;
+        if (owner != Cast::toOwner(obj)) {
+            m_ref = obj;
+            if (owner) {
+                Cast::tracker(owner).getManager()->retire((void*)owner, &SwappableManager::destroyObject<T>);
+            }
+        }
+    }
+
+    /* Hotswap all the references of the owned object to the new object, which
+       becomes owned. Old object is retired after the swap.
+       Return false if current object is NULL or if new object is NULL.        */
+    bool hotSwapTo(T* obj)
+    {
+        const void* owner = m_ref.instance.ptr;
+        if (owner && obj && (owner != Cast::toOwner(obj))) {
+            Swappable&        a   = Cast::tracker(owner);
+            SwappableManager* mgr = a.getManager();
+            mgr->replaceObject(&a, &obj->_trackMe);
+            mgr->retire((void*)owner, &SwappableManager::destroyObject<T>);
+            return true;
+        } else {
+            return (owner != 0) && (obj != 0);
+        }
+    }
+};
+
+/*  ====================================================================================
+        Shared owning reference : the count of owners is kept in the manager entry,
+        no control block. Object is retired (SwappableManager::retire) when the last
+        owner is released. Plain hotswap_ptr on the object do not own it.
+        Swaps move the owners with the other references, and the count with them :
+        hotSwapTo retires the old object. A swap done by other means (hotswap_ptr::hotSwapTo,
+        queueSwap, scheduler) also moves the owners to the new object and leaves the
+        old one unowned : the caller retires it.
+        Incremental and lazy swaps of an owned object are done at once, selective
+        swaps (replaceGroup, replaceFiltered) leave it untouched : the count always
+        matches the owners referencing an object.
+        Same thread rule as the manager, count is not atomic.
+    ====================================================================================*/
+template < typename T >
+class hotswap_shared_ptr {
+private:
+    hotswap_ptr<T>      m_ref;
+
+    typedef SwappableCast<T> Cast;
+
+    void attach(T* obj) {
+        m_ref = obj;
+        if (obj) {
+            obj->_trackMe.getManager()->acquireShared(obj->_trackMe.getSlot());
+        }
+    }
+
+    void detach() {
+        const void* owner = m_ref.instance.ptr;
+        if (owner) {
+            Swappable&        tracker = Cast::tracker(owner);
+            SwappableManager* mgr     = tracker.getManager();
+            SwappableIndex    handle  = tracker.getSlot();
+            m_ref = 0;
+            if (mgr->releaseShared(handle) == 0) {
+                mgr->retire((void*)owner, &SwappableManager::destroyObject<T>);
+            }
+        }
+    }
+public:
+    hotswap_shared_ptr()
+    {
+    }
+
+    explicit hotswap_shared_ptr(T* pValue)
+    {
+        attach(pValue);
+    }
+
+    hotswap_shared_ptr(const hotswap_shared_ptr<T>& sp)
+    {
+        attach(sp.get());
+    }
+
+    ~hotswap_shared_ptr()
+    {
+        detach();
+    }
+
+    T& operator* () const
+    {
+        return *get();
+    }
+
+    T* operator-> () const
+    {
+        return get();
+    }
+
+    T* get() const
+    {
+        return Cast::fromOwner(m_ref.instance.ptr);
+    }
+
+    /* Number of owners of the object, 0 if NULL                                 */
+    unsigned int useCount() const
+    {
+        const void* owner = m_ref.instance.ptr;
+        if (owner) {
+            const Swappable& tracker = Cast::tracker(owner);
+            return tracker.getManager()->m_arrayList[tracker.getSlot()].m_shared;
+        }
+        return 0;
+    }
+
+    hotswap_shared_ptr<T>& operator = (const hotswap_shared_ptr<T>& sp)
+    {
+        reset(sp.get());
+        return *this;
+    }
+
+    // Support for NULL, it can't be helped.
+    hotswap_shared_ptr<T>& operator = (int obj)
+    {
+        if (obj == 0) {
+            detach();
+        }
+        return *this;
+    }
+
+    /* Release the current object and own the new one (can be NULL)             */
+    void reset(T* obj)
+    {
+        if (m_ref.instance.ptr != Cast::toOwner(obj)) {
+            // Own the new object first : it may only be kept alive by the current one.
+            hotswap_shared_ptr<T> keep(obj);
+            detach();
+            attach(obj);
+        }
+    }
+
+    /* Hotswap all the references and owners of the current object to the new object.
+       Old object is retired after the swap.
+       Return false if current object is NULL or if new object is NULL.        */
+    bool hotSwapTo(T* obj)
+    {
+        const void* owner = m_ref.instance.ptr;
+        if (owner && obj && (owner != Cast::toOwner(obj))) {
+            Swappable&        a   = Cast::tracker(owner);
+            SwappableManager* mgr = a.getManager();
+            mgr->replaceObject(&a, &obj->_trackMe);
+            mgr->retire((void*)owner, &SwappableManager::destroyObject<T>);
+            return true;
+        } else {
+            return (owner != 0) && (obj != 0);
+        }
+    }
+};
+
+/*  ====================================================================================
+        Handle reference : resolves through the manager instead of storing the pointer.
+        One more indirection when using the pointer, but no link list to maintain
+        and swaps can be published to all handle references at once (see stageSwap).
+    ====================================================================================*/
+template < typename T >
+class hotswap_handle {
+private:
+    SwappableManager*   m_mgr;
+    SwappableIndex      m_handle;
+public:
+    hotswap_handle()
+    :m_mgr   (0)
+    ,m_handle(0)
+    {
+    }
+
+    hotswap_handle(T* pValue)
+    :m_mgr   (0)
+    ,m_handle(0)
+    {
+        *this = pValue;
+    }
+
+    hotswap_handle<T>& operator = (T* obj)
+    {
+        if (obj) {
+            m_mgr    = obj->_trackMe.getManager();
+            m_handle = obj->_trackMe.getSlot();
+        } else {
+            m_mgr    = 0;
+        }
+        return *this;
+    }
+
+    // Support for NULL, it can't be helped.
+    hotswap_handle<T>& operator = (int obj)
+    {
+        if (obj == 0) {
+            m_mgr    = 0;
+        }
+        return *this;
+    }
+
+    T* get() const
+    {
+        return m_mgr ? SwappableCast<T>::fromOwner(m_mgr->resolveHandle(m_handle)) : 0;
+    }
+
+    T& operator* () const
+    {
+        return *get();
+    }
+
+    T* operator-> () const
+    {
+        return get();
+    }
+};
+
 };
 
 #endif
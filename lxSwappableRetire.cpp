@@ -0,0 +1,62 @@
+#include "lxSwappableRetire.h"
+
+namespace lx {
+
+/*static*/
+int SwappableRetireQueue::getAllocSize(int maxRetired) {
+    return (int)(maxRetired * sizeof(RETIRED));
+}
+
+bool SwappableRetireQueue::init(void* alignPtr_buffer, int bufferSize, int maxRetired) {
+    if (bufferSize < getAllocSize(maxRetired)) {
+        return false;
+    }
+
+    m_retired           = (RETIRED*)alignPtr_buffer;
+    m_maxRetired        = maxRetired;
+    m_first             = 0;
+    m_count             = 0;
+    return true;
+}
+
+void SwappableRetireQueue::release() {
+    flush(-1);
+}
+
+void SwappableRetireQueue::retire(void* object, SwappableDestroyFunc destroy) {
+    if (m_count == m_maxRetired) {
+        destroy(object);
+        return;
+    }
+
+    int pos = m_first + m_count;
+    if (pos >= m_maxRetired) {
+        pos -= m_maxRetired;
+    }
+    m_retired[pos].m_object  = object;
+    m_retired[pos].m_destroy = destroy;
+    m_count++;
+}
+
+int SwappableRetireQueue::flush(int maxCount) {
+    int destroyed = 0;
+    while ((m_count > 0) && ((maxCount < 0) || (destroyed < maxCount))) {
+        // Pop first : a destructor may retire other objects.
+        RETIRED retired = m_retired[m_first];
+        if (++m_first == m_maxRetired) {
+            m_first = 0;
+        }
+        m_count--;
+
+        retired.m_destroy(retired.m_object);
+        destroyed++;
+    }
+    return destroyed;
+}
+
+/*static*/
+void SwappableRetireQueue::retireHandler(void* context, void* object, SwappableDestroyFunc destroy) {
+    ((SwappableRetireQueue*)context)->retire(object, destroy);
+}
+
+} // End namespace lx
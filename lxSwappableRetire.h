@@ -0,0 +1,81 @@
+/*
+// ====================================================================================
+//  Deferred destruction of retired objects.
+//
+//    - Plug into the manager retire path : objects retired by the manager
+//      (hotswap_unique_ptr, SwapRequest::m_retireOld, SwappableManager::retire)
+//      are queued instead of destroyed inside the swap.
+//    - Destruction is done later by flush(), at a point chosen by the user
+//      (ie end of frame), and can be spread over several calls with a budget.
+//    - User has to provide memory, no allocation is performed by the system.
+//
+//  Usage :
+//    SwappableRetireQueue queue;
+//    queue.init(buffer, SwappableRetireQueue::getAllocSize(256), 256);
+//    queue.attach(mgr);
+//
+//    owner.hotSwapTo(newObj);      // Old object is queued.
+//    ...
+//    queue.flush(16);              // Destroy at most 16 objects.
+//
+//  Note :
+//  - Destroying a swappable object unregisters it from the manager : flush follows
+//    the manager rule, same thread, or protected by the user.
+//  - When the queue is full, the object is destroyed immediately.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_RETIRE_H
+#define LX_SWAPPABLE_RETIRE_H
+
+#include "lxSwappablePointer.h"
+
+namespace lx {
+
+class SwappableRetireQueue {
+public:
+    /* Function for the client to know how much memory is needed in advance before
+       doing calling the init(...) function */
+    static
+    int     getAllocSize    (int maxRetired);
+
+    /* Setup buffer used for the retired objects.
+       Return true if successful, false if memory was not big enough.            */
+    bool init            (void* alignPtr_buffer, int bufferSize, int maxRetired);
+
+    /* Destroy all the queued objects                                            */
+    void release         ();
+
+    /* Install the queue as the retire handler of the manager                   */
+    void attach          (SwappableManager* mgr) {
+        mgr->setRetireHandler(&SwappableRetireQueue::retireHandler, this);
+    }
+
+    /* Queue an object for destruction, destroyed now if the queue is full.     */
+    void retire          (void* object, SwappableDestroyFunc destroy);
+
+    /* Destroy at most maxCount queued objects in retire order, all if negative.
+       Return the number of objects destroyed.                                   */
+    int  flush           (int maxCount);
+
+    /* Number of objects waiting for destruction                                 */
+    int  getPending      () const { return m_count; }
+
+private:
+    struct RETIRED {
+        void*                   m_object;
+        SwappableDestroyFunc    m_destroy;
+    };
+
+    static
+    void retireHandler   (void* context, void* object, SwappableDestroyFunc destroy);
+
+    RETIRED*            m_retired;                      // Ring of retired objects.
+    int                 m_maxRetired;
+    int                 m_first;                        // Oldest queued object.
+    int                 m_count;
+};
+
+};
+
+#endif
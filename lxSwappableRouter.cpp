@@ -0,0 +1,81 @@
+#include "lxSwappableRouter.h"
+
+namespace lx {
+
+SwappableRouter::SwappableRouter() {
+    for (int n=0; n < VARIANT_COUNT; n++) {
+        m_tracker[n]                = 0;
+        m_owner  [n]                = 0;
+        m_stats  [n].m_references   = 0;
+    }
+    reset();
+}
+
+void SwappableRouter::reset() {
+    for (int n=0; n < VARIANT_COUNT; n++) {
+        m_stats[n].m_calls          = 0;
+        m_stats[n].m_nanoseconds    = 0;
+    }
+}
+
+size_t SwappableRouter::splitOwners(Swappable* a, Swappable* b, const void* ownerA, const void* ownerB, unsigned int percentB) {
+    m_tracker[VARIANT_A]    = a;
+    m_tracker[VARIANT_B]    = b;
+    m_owner  [VARIANT_A]    = ownerA;
+    m_owner  [VARIANT_B]    = ownerB;
+    reset();
+
+    // Bresenham like spread : references moved are evenly spaced along the list.
+    SPLIT split;
+    split.m_percent         = (percentB > 100) ? 100 : percentB;
+    split.m_accumulator     = 0;
+    split.m_visited         = 0;
+    size_t moved = a->getManager()->replaceFiltered(a, b, &SwappableRouter::splitFilter, &split);
+
+    m_stats[VARIANT_A].m_references = split.m_visited - moved;
+    m_stats[VARIANT_B].m_references = moved;
+    return moved;
+}
+
+size_t SwappableRouter::promote() {
+    Swappable* a = m_tracker[VARIANT_A];
+    Swappable* b = m_tracker[VARIANT_B];
+    if (!a) {
+        return 0;
+    }
+    size_t moved = a->getManager()->replaceFiltered(a, b, &SwappableRouter::allFilter, 0);
+    m_stats[VARIANT_B].m_references += moved;
+    m_stats[VARIANT_A].m_references  = 0;
+    return moved;
+}
+
+size_t SwappableRouter::rollback() {
+    Swappable* a = m_tracker[VARIANT_A];
+    Swappable* b = m_tracker[VARIANT_B];
+    if (!a) {
+        return 0;
+    }
+    size_t moved = b->getManager()->replaceFiltered(b, a, &SwappableRouter::allFilter, 0);
+    m_stats[VARIANT_A].m_references += moved;
+    m_stats[VARIANT_B].m_references  = 0;
+    return moved;
+}
+
+/*static*/
+bool SwappableRouter::splitFilter(void* context, const void* /*reference*/) {
+    SPLIT* split = (SPLIT*)context;
+    split->m_visited++;
+    split->m_accumulator += split->m_percent;
+    if (split->m_accumulator >= 100) {
+        split->m_accumulator -= 100;
+        return true;
+    }
+    return false;
+}
+
+/*static*/
+bool SwappableRouter::allFilter(void* /*context*/, const void* /*reference*/) {
+    return true;
+}
+
+} // End namespace lx
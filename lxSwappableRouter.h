@@ -0,0 +1,195 @@
+/*
+// ====================================================================================
+//  A/B routing of references between two implementations, with per-variant counters.
+//
+//    - split() moves a ratio of the references of implementation A to implementation B,
+//      in a single walk of the reference list (SwappableManager::replaceFiltered).
+//      The split is deterministic : one reference out of N in list order.
+//    - hotswap_routed_ptr<T> is a reference measuring each call made through it :
+//      call count and latency are accumulated for the variant which served the call.
+//    - promote() moves everyone to B, rollback() moves everyone back to A.
+//    - No allocation, plain hotswap_ptr keep their zero overhead.
+//
+//  Usage :
+//    SwappableRouter router;
+//    router.split(physicsV1, physicsV2, 10);               // 10% of the references to V2.
+//
+//    hotswap_routed_ptr<Physics> physics(physicsV1, &router);
+//    physics->step(dt);                                    // Measured.
+//
+//    const SwappableRouter::STATS& b = router.getStats(SwappableRouter::VARIANT_B);
+//    printf("%llu calls, %llu ns\n", b.m_calls, b.m_nanoseconds);
+//    router.promote();                                     // Or rollback().
+//
+//  Note :
+//  - Routing changes the reference lists : thread owning the manager, as any swap.
+//  - Counters are updated atomically, calls can be measured from any thread.
+//  - rollback() moves all the references of B : B should only be used through the router.
+//  - An implementation with owning references (hotswap_shared_ptr) is not routed.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_ROUTER_H
+#define LX_SWAPPABLE_ROUTER_H
+
+#include "lxSwappablePointer.h"
+#include "lxSwappablePerf.h"
+
+namespace lx {
+
+class SwappableRouter {
+public:
+    enum VARIANT {
+        VARIANT_A = 0,                  // Current implementation.
+        VARIANT_B,                      // Implementation under test.
+        VARIANT_COUNT
+    };
+
+    /* Counters for one variant                                                  */
+    struct STATS {
+        unsigned long long  m_calls;            // Measured calls.
+        unsigned long long  m_nanoseconds;      // Total time of the measured calls.
+        size_t              m_references;       // References routed to the variant by the last split.
+    };
+
+    SwappableRouter();
+
+    /* Route percentB % of the references of a to b (0..100), counters are reset.
+       Return the number of references moved.                                    */
+    template<class T>
+    size_t split         (T* a, T* b, unsigned int percentB) {
+        return splitOwners(&a->_trackMe, &b->_trackMe, SwappableCast<T>::toOwner(a), SwappableCast<T>::toOwner(b), percentB);
+    }
+
+    /* Move all the references of A to B. Return the number of references moved. */
+    size_t promote       ();
+
+    /* Move all the references of B to A. Return the number of references moved. */
+    size_t rollback      ();
+
+    /* Account a call served by the given owner, ignored if not a variant.       */
+    void record          (const void* owner, unsigned long long nanoseconds) {
+        for (int n=0; n < VARIANT_COUNT; n++) {
+            if (owner == m_owner[n]) {
+                SwappableAtomic::fetchAdd(&m_stats[n].m_calls,       1ULL);
+                SwappableAtomic::fetchAdd(&m_stats[n].m_nanoseconds, nanoseconds);
+                return;
+            }
+        }
+    }
+
+    /* Counters of a variant                                                     */
+    const STATS&
+         getStats        (VARIANT variant) const { return m_stats[variant]; }
+
+    /* Reset call counters                                                       */
+    void reset           ();
+
+private:
+    /* Filter context for split                                                  */
+    struct SPLIT {
+        unsigned int    m_percent;
+        unsigned int    m_accumulator;
+        size_t          m_visited;
+    };
+
+    size_t splitOwners   (Swappable* a, Swappable* b, const void* ownerA, const void* ownerB, unsigned int percentB);
+
+    static
+    bool splitFilter     (void* context, const void* reference);
+
+    static
+    bool allFilter       (void* context, const void* reference);
+
+    Swappable*          m_tracker[VARIANT_COUNT];
+    const void*         m_owner  [VARIANT_COUNT];
+    STATS               m_stats  [VARIANT_COUNT];
+};
+
+/*  ====================================================================================
+        Reference measuring the calls made through operator->.
+        The call object lives until the end of the full expression : the time of
+        the whole call is recorded for the variant which served it.
+    ====================================================================================*/
+template < typename T >
+class hotswap_routed_ptr {
+public:
+    class Call {
+    public:
+        Call(T* obj, SwappableRouter* router)
+        :m_obj      (obj)
+        ,m_router   (router)
+        ,m_start    (SwappablePerf::now())
+        {
+        }
+
+        // Only the last copy records.
+        Call(const Call& call)
+        :m_obj      (call.m_obj)
+        ,m_router   (call.m_router)
+        ,m_start    (call.m_start)
+        {
+            call.m_router = 0;
+        }
+
+        ~Call() {
+            if (m_router) {
+                m_router->record(SwappableCast<T>::toOwner(m_obj), SwappablePerf::now() - m_start);
+            }
+        }
+
+        T* operator-> () const { return m_obj; }
+    private:
+        Call& operator= (const Call&);
+
+        T*                          m_obj;
+        mutable SwappableRouter*    m_router;
+        unsigned long long          m_start;
+    };
+
+    hotswap_routed_ptr()
+    :m_router(0)
+    {
+    }
+
+    hotswap_routed_ptr(T* pValue, SwappableRouter* router)
+    :m_ref      (pValue)
+    ,m_router   (router)
+    {
+    }
+
+    /* Measured call                                                             */
+    Call operator-> ()
+    {
+        return Call(m_ref.operator->(), m_router);
+    }
+
+    /* Unmeasured access                                                         */
+    T* get()
+    {
+        return m_ref.operator->();
+    }
+
+    hotswap_routed_ptr<T>& operator = (T* obj)
+    {
+        m_ref = obj;
+        return *this;
+    }
+
+    // Support for NULL, it can't be helped.
+    hotswap_routed_ptr<T>& operator = (int obj)
+    {
+        m_ref = obj;
+        return *this;
+    }
+
+    void setRouter(SwappableRouter* router) { m_router = router; }
+
+private:
+    hotswap_ptr<T>      m_ref;
+    SwappableRouter*    m_router;
+};
+
+};
+
+#endif
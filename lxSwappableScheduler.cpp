@@ -0,0 +1,193 @@
+#include "lxSwappableScheduler.h"
+#include "lxSwappablePerf.h"
+
+namespace lx {
+
+/*static*/
+int SwappableScheduler::getAllocSize(int maxSwaps, int maxEdges) {
+    unsigned int bufferSizeNodes            = maxSwaps       * sizeof(NODE);
+    unsigned int bufferSizeEdges            = maxEdges       * sizeof(EDGE);
+    unsigned int bufferSizeOrder            = maxSwaps       * sizeof(int );
+    unsigned int bufferSizeLevels           = (maxSwaps + 1) * sizeof(int );
+    unsigned int bufferSizeLanes            = (maxSwaps + 1) * sizeof(int );
+    return (int)(bufferSizeNodes + bufferSizeEdges + bufferSizeOrder + bufferSizeLevels + bufferSizeLanes);
+}
+
+bool SwappableScheduler::init(void* alignPtr_buffer, int bufferSize, int maxSwaps, int maxEdges) {
+    if (bufferSize < getAllocSize(maxSwaps, maxEdges)) {
+        return false;
+    }
+
+    unsigned char* ptr  = (unsigned char*)alignPtr_buffer;
+    m_nodes             = (NODE*)ptr;
+    m_edges             = (EDGE*)&m_nodes[maxSwaps];
+    m_order             = (int* )&m_edges[maxEdges];
+    m_levelStart        = &m_order[maxSwaps];
+    m_laneStart         = &m_levelStart[maxSwaps + 1];
+    m_maxSwaps          = maxSwaps;
+    m_maxEdges          = maxEdges;
+    clear();
+    return true;
+}
+
+void SwappableScheduler::clear() {
+    m_swapCount         = 0;
+    m_edgeCount         = 0;
+    m_levelCount        = 0;
+    m_maxLaneCount      = 0;
+    m_totalTime         = 0;
+    m_criticalPathTime  = 0;
+}
+
+int SwappableScheduler::addSwap(Swappable* oldInstance, Swappable* newInstance) {
+    if ((m_swapCount == m_maxSwaps) || (oldInstance->getManager() != newInstance->getManager())) {
+        return -1;
+    }
+    NODE& node          = m_nodes[m_swapCount];
+    node.m_oldInstance  = oldInstance;
+    node.m_newInstance  = newInstance;
+    node.m_mgr          = oldInstance->getManager();
+    node.m_firstEdge    = -1;
+    node.m_inDegree     = 0;
+    node.m_duration     = 0;
+    node.m_finish       = 0;
+    return m_swapCount++;
+}
+
+bool SwappableScheduler::addDependency(int before, int after) {
+    if ((m_edgeCount == m_maxEdges)
+     || (before < 0) || (before >= m_swapCount)
+     || (after  < 0) || (after  >= m_swapCount)) {
+        return false;
+    }
+    EDGE& edge          = m_edges[m_edgeCount];
+    edge.m_to           = after;
+    edge.m_next         = m_nodes[before].m_firstEdge;
+    m_nodes[before].m_firstEdge = m_edgeCount++;
+    return true;
+}
+
+bool SwappableScheduler::sort() {
+    //
+    // Kahn algorithm, one level at a time : each level only depends on previous ones.
+    //
+    for (int n=0; n < m_swapCount; n++) {
+        m_nodes[n].m_inDegree = 0;
+    }
+    for (int e=0; e < m_edgeCount; e++) {
+        m_nodes[m_edges[e].m_to].m_inDegree++;
+    }
+
+    int count = 0;
+    for (int n=0; n < m_swapCount; n++) {
+        if (m_nodes[n].m_inDegree == 0) {
+            m_order[count++] = n;
+        }
+    }
+
+    m_levelCount = 0;
+    int start    = 0;
+    while (start < count) {
+        int end = count;
+        m_levelStart[m_levelCount++] = start;
+        for (int n=start; n < end; n++) {
+            for (int e = m_nodes[m_order[n]].m_firstEdge; e != -1; e = m_edges[e].m_next) {
+                int to = m_edges[e].m_to;
+                if (--m_nodes[to].m_inDegree == 0) {
+                    m_order[count++] = to;
+                }
+            }
+        }
+        start = end;
+    }
+    m_levelStart[m_levelCount] = count;
+
+    // Swaps left out are part of a cycle.
+    return (count == m_swapCount);
+}
+
+int SwappableScheduler::splitLanes(int start, int end) {
+    //
+    // Manager state is not locked : all the swaps of a manager go in the same lane.
+    // Few managers are expected, each pass gathers one of them.
+    //
+    int laneCount = 0;
+    int n         = start;
+    while (n < end) {
+        SwappableManager* mgr = m_nodes[m_order[n]].m_mgr;
+        m_laneStart[laneCount++] = n;
+        int last = n + 1;
+        for (int k=last; k < end; k++) {
+            if (m_nodes[m_order[k]].m_mgr == mgr) {
+                int swapped     = m_order[k];
+                m_order[k]      = m_order[last];
+                m_order[last++] = swapped;
+            }
+        }
+        n = last;
+    }
+    m_laneStart[laneCount] = end;
+    return laneCount;
+}
+
+/*static*/
+void SwappableScheduler::runJob(void* arg, int index) {
+    SwappableScheduler* sched = (SwappableScheduler*)arg;
+    for (int n=sched->m_laneStart[index]; n < sched->m_laneStart[index+1]; n++) {
+        NODE& node = sched->m_nodes[sched->m_order[n]];
+
+        unsigned long long start = SwappablePerf::now();
+        node.m_mgr->replaceObject(node.m_oldInstance, node.m_newInstance);
+        node.m_duration = SwappablePerf::now() - start;
+    }
+}
+
+bool SwappableScheduler::run(const SwappableJobPool* pool) {
+    m_totalTime         = 0;
+    m_criticalPathTime  = 0;
+    m_maxLaneCount      = 0;
+    if (!sort()) {
+        m_levelCount    = 0;
+        return false;
+    }
+
+    unsigned long long start = SwappablePerf::now();
+    for (int level=0; level < m_levelCount; level++) {
+        int count = splitLanes(m_levelStart[level], m_levelStart[level+1]);
+        if (count > m_maxLaneCount) {
+            m_maxLaneCount = count;
+        }
+
+        if (pool && (count > 1)) {
+            pool->m_parallelFor(pool->m_context, count, &SwappableScheduler::runJob, this);
+        } else {
+            for (int n=0; n < count; n++) {
+                runJob(this, n);
+            }
+        }
+    }
+    m_totalTime = SwappablePerf::now() - start;
+
+    //
+    // Critical path : longest chain of measured swap times, following the sorted order.
+    //
+    for (int n=0; n < m_swapCount; n++) {
+        m_nodes[n].m_finish = 0;
+    }
+    for (int n=0; n < m_swapCount; n++) {
+        NODE& node    = m_nodes[m_order[n]];
+        node.m_finish += node.m_duration;
+        if (node.m_finish > m_criticalPathTime) {
+            m_criticalPathTime = node.m_finish;
+        }
+        for (int e = node.m_firstEdge; e != -1; e = m_edges[e].m_next) {
+            NODE& next = m_nodes[m_edges[e].m_to];
+            if (next.m_finish < node.m_finish) {
+                next.m_finish = node.m_finish;
+            }
+        }
+    }
+    return true;
+}
+
+} // End namespace lx
@@ -0,0 +1,135 @@
+/*
+// ====================================================================================
+//  Dependency ordered swap scheduling.
+//
+//    - Register swaps and "must happen before" edges between them
+//      (ie a mesh swapped before the materials referencing it).
+//    - Swaps are ordered topologically and grouped by level. Inside a level the
+//      swaps are split in lanes, one per manager : lanes run in parallel on a pool
+//      given by the caller, the swaps of a lane one after another.
+//    - Report the total time and the critical path time (longest dependency chain).
+//    - User has to provide memory, no allocation is performed by the system.
+//
+//  Usage :
+//    SwappableScheduler sched;
+//    sched.init(buffer, SwappableScheduler::getAllocSize(64, 128), 64, 128);
+//    int mesh     = sched.addSwap(oldMesh, newMesh);
+//    int material = sched.addSwap(oldMat,  newMat );
+//    sched.addDependency(mesh, material);
+//    sched.run(&pool);           // NULL pool runs everything on the calling thread.
+//
+//  Note :
+//  - A swap writes state of its whole manager (entries, forwards, versions, lists
+//    of the targets), never of another one : swaps of the same manager are never
+//    run at the same time, parallelism only comes from several managers.
+//  - Order between swaps of the same level is not defined : two swaps sharing an
+//    object must be ordered with an edge.
+//  - Performance instrumentation (LX_SWAPPABLE_PERF) is not thread safe : managers
+//    must not share the same SwappablePerf while running with a pool.
+// ====================================================================================
+*/
+
+#ifndef LX_SWAPPABLE_SCHEDULER_H
+#define LX_SWAPPABLE_SCHEDULER_H
+
+#include "lxSwappablePointer.h"
+
+namespace lx {
+
+/*  ====================================================================================
+    Thread pool interface provided by the caller.
+    ==================================================================================== */
+struct SwappableJobPool {
+    /* Run job(arg, index) for each index in [0, count) and return when all are done. */
+    void      (*m_parallelFor)(void* context, int count, void (*job)(void* arg, int index), void* arg);
+    void*       m_context;
+};
+
+/*  ====================================================================================
+    Swap scheduler.
+    ==================================================================================== */
+class SwappableScheduler {
+public:
+    /* Function for the client to know how much memory is needed in advance before
+       doing calling the init(...) function */
+    static
+    int     getAllocSize    (int maxSwaps, int maxEdges);
+
+    /* Setup buffer used for the swaps and dependencies.
+       Return true if successful, false if memory was not big enough.            */
+    bool init            (void* alignPtr_buffer, int bufferSize, int maxSwaps, int maxEdges);
+
+    /* Remove all swaps and dependencies                                         */
+    void clear           ();
+
+    /* Register a swap, return its id or -1 if full or if the objects belong to
+       different managers.                                                       */
+    int  addSwap         (Swappable* oldInstance, Swappable* newInstance);
+
+    template<class T>
+    int  addSwap         (T* oldObj, T* newObj) {
+        return addSwap(&oldObj->_trackMe, &newObj->_trackMe);
+    }
+
+    /* Swap 'before' must be done before swap 'after' starts.
+       Return false if full or invalid id.                                       */
+    bool addDependency   (int before, int after);
+
+    /* Execute all the swaps in dependency order, in their own manager. Lanes of
+       a level run in parallel on the pool.
+       Return false if dependencies contain a cycle : nothing is swapped.       */
+    bool run             (const SwappableJobPool* pool);
+
+    /* Results of the last run, in nanoseconds                                   */
+    unsigned long long getTotalTime        () const { return m_totalTime;        }
+    unsigned long long getCriticalPathTime () const { return m_criticalPathTime; }
+
+    /* Number of groups executed one after another in the last run             */
+    int  getLevelCount   () const { return m_levelCount; }
+
+    /* Largest number of lanes run at the same time in the last run             */
+    int  getMaxLaneCount () const { return m_maxLaneCount; }
+
+private:
+    struct NODE {
+        Swappable*          m_oldInstance;
+        Swappable*          m_newInstance;
+        SwappableManager*   m_mgr;                      // Manager of both objects.
+        int                 m_firstEdge;                // First outgoing edge, -1 if none.
+        int                 m_inDegree;                 // Pending dependencies while sorting.
+        unsigned long long  m_duration;                 // Measured swap time.
+        unsigned long long  m_finish;                   // Critical path length up to this swap.
+    };
+
+    struct EDGE {
+        int                 m_to;                       // Dependent swap.
+        int                 m_next;                     // Next outgoing edge of the same swap.
+    };
+
+    static
+    void runJob          (void* arg, int index);
+
+    bool sort            ();
+
+    /* Move the swaps of the same manager together inside [start, end) of m_order,
+       fill m_laneStart and return the number of lanes.                          */
+    int  splitLanes      (int start, int end);
+
+    NODE*               m_nodes;
+    EDGE*               m_edges;
+    int*                m_order;                        // Swaps sorted by level.
+    int*                m_levelStart;                   // Start of each level inside m_order, one more for the end.
+    int*                m_laneStart;                    // Start of each lane of the running level, one more for the end.
+    int                 m_maxSwaps;
+    int                 m_maxEdges;
+    int                 m_swapCount;
+    int                 m_edgeCount;
+    int                 m_levelCount;
+    int                 m_maxLaneCount;
+    unsigned long long  m_totalTime;
+    unsigned long long  m_criticalPathTime;
+};
+
+};
+
+#endif
@@ -1,6 +1,37 @@
 #include "lxSwappablePointer.h"
+#include "lxSwappableArchive.h"
+#include "lxSwappableExternal.h"
+#include "lxSwappableGroup.h"
+#include "lxSwappableHazard.h"
+#include "lxSwappableRetire.h"
+#include "lxSwappableRouter.h"
+#include "lxSwappableScheduler.h"
+#include "lxSwappablePerf.h"
+#include <stdio.h>
+#include <string.h>
+
+// File watcher needs inotify.
+#ifdef __linux__
+#define TEST_ASSET
+#include "lxSwappableAsset.h"
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+// Coroutine and function holders need C++20 / C++11 : built by the "Debug C++20" target.
+#if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && (_MSVC_LANG >= 202002L))
+#define TEST_CPP20
+#include "lxSwappableCoroutine.h"
+#include "lxSwappableFunction.h"
+#include <thread>
+#endif
+
 using namespace lx;
 
+static int g_failures = 0;
+
+#define CHECK(cond)		if (!(cond)) { printf("%s(%d) : check failed : %s\n", __FILE__, __LINE__, #cond); g_failures++; }
+
 class Sample {
 	MAKESWAPPABLE(Sample)
 public:
@@ -10,26 +41,1325 @@ public:
 	}
 };
 
-int main(int argc, char* argv[])
+// Class from another library, can not use MAKESWAPPABLE.
+struct ThirdParty {
+	int value;
+};
+
+// Object with a value, to see where the references point.
+class Value {
+	MAKESWAPPABLE(Value)
+public:
+	Value(SwappableManager* mgr, int v)
+	:_trackMe(this,mgr)
+	,value(v)
+	{
+	}
+
+	int value;
+};
+
+// Two versions of a class with the same data layout, swapped in place.
+class Actor {
+	MAKESWAPPABLE(Actor)
+public:
+	Actor(SwappableManager* mgr)
+	:_trackMe(this,mgr)
+	{
+	}
+
+	Actor(const Actor&, const SwappableInPlace& tag)
+	:_trackMe(tag)
+	{
+	}
+
+	virtual ~Actor() { }
+	virtual int update() = 0;
+};
+
+static int g_enemyDestroyed = 0;
+
+class Enemy : public Actor {
+	SWAPPABLE_LAYOUT(0x5E1A)
+public:
+	Enemy(SwappableManager* mgr)
+	:Actor	(mgr)
+	,hp		(100)
+	,speed	(2)
+	{
+	}
+
+	~Enemy() { g_enemyDestroyed++; }
+
+	virtual int update() { return hp; }
+
+	int hp;
+	int speed;
+};
+
+class EnemyV2 : public Actor {
+	SWAPPABLE_LAYOUT(0x5E1A)
+public:
+	EnemyV2(const Enemy& previous, const SwappableInPlace& tag)
+	:Actor	(previous, tag)
+	,hp		(previous.hp)
+	,speed	(previous.speed)
+	{
+	}
+
+	virtual int update() { hp -= 1; return hp * speed; }
+
+	int hp;
+	int speed;
+};
+
+//
+// In place swap keeps the state, the registration and the references
+// (also checked by the optimized builds).
+//
+void testInPlace(SwappableManager* mgr)
+{
+	Enemy* enemy = new Enemy(mgr);
+	hotswap_ptr<Actor> refs[8];
+	for (int n=0; n < 8; n++) {
+		refs[n] = enemy;
+	}
+	SwappableIndex slot = enemy->_trackMe.getSlot();
+	enemy->hp = 42;
+	CHECK(refs[3]->update() == 42);
+
+	EnemyV2* swapped = swapInPlace<EnemyV2>(enemy);
+	CHECK((void*)swapped == (void*)enemy);
+	CHECK(swapped->hp == 42);
+	CHECK(g_enemyDestroyed == 2);			// Previous version and its copy.
+	CHECK(swapped->_trackMe.getSlot() == slot);
+	CHECK(refs[7]->update() == 82);
+	CHECK(refs[0].resolve() == swapped);
+
+	// Still registered : a regular swap moves the references.
+	Enemy* next = new Enemy(mgr);
+	CHECK(refs[0].hotSwapTo(next));
+	CHECK(refs[5]->update() == 100);
+	for (int n=0; n < 8; n++) {
+		refs[n] = 0;
+	}
+	delete (Actor*)swapped;
+	delete next;
+}
+
+#ifdef TEST_CPP20
+//
+// Coroutine resumed by drainSwaps(), the awaitable being copied before the suspension.
+//
+struct TestTask {
+	struct promise_type {
+		TestTask			get_return_object	()			{ return TestTask(); }
+		std::suspend_never	initial_suspend		()			{ return std::suspend_never(); }
+		std::suspend_never	final_suspend		() noexcept	{ return std::suspend_never(); }
+		void				return_void			()			{ }
+		void				unhandled_exception	()			{ }
+	};
+};
+
+static int g_resumed = 0;
+
+static void resumeCounted(void* context, std::coroutine_handle<> coroutine)
+{
+	(*(int*)context)++;
+	coroutine.resume();
+}
+
+static TestTask reloadValue(SwappableManager* mgr, hotswap_ptr<Value>* ref, Value* oldValue, Value* newValue)
+{
+	SwapAwaitable aw = mgr->swapAsync(oldValue, newValue).via(&resumeCounted, &g_resumed);
+	co_await aw;
+	CHECK((*ref)->value == 2);
+}
+
+static int timesTwo	(int v) { return v * 2; }
+static int timesTen	(int v) { return v * 10; }
+
+void testCpp20(SwappableManager* mgr)
+{
+	Value a(mgr, 1);
+	Value b(mgr, 2);
+	hotswap_ptr<Value> ref;
+	ref = &a;
+
+	reloadValue(mgr, &ref, &a, &b);
+	CHECK(ref->value == 1);					// Suspended until the drain.
+	CHECK(mgr->drainSwaps() == 1);
+	CHECK(g_resumed == 1);
+	CHECK(ref->value == 2);
+	ref = 0;
+
+	SwappableFunction<int(int)> implA(&timesTwo, mgr);
+	SwappableFunction<int(int)> implB(&timesTen, mgr);
+	hotswap_fn<int(int)> holders[4];
+	for (int n=0; n < 4; n++) {
+		holders[n] = &implA;
+	}
+	CHECK(holders[3](4) == 8);
+	CHECK(holders[0].hotSwapTo(&implB));
+	for (int n=0; n < 4; n++) {
+		CHECK(holders[n](4) == 40);
+		holders[n] = 0;
+	}
+}
+#endif
+
+//
+// Lazy swaps heal references on checked access, through chains, and never
+// onto an object reusing the entry of a destroyed one.
+//
+void testForward(SwappableManager* mgr)
+{
+	Value a(mgr, 1);
+	Value b(mgr, 2);
+	Value c(mgr, 3);
+	hotswap_ptr<Value> refs[4];
+	for (int n=0; n < 4; n++) {
+		refs[n] = &a;
+	}
+
+	mgr->forwardObject(&a._trackMe, &b._trackMe);
+	CHECK(refs[0]->value == 1);				// Not moved before a checked access.
+	CHECK(refs[0].resolve()->value == 2);
+	CHECK(refs[0]->value == 2);
+	mgr->forwardObject(&b._trackMe, &c._trackMe);
+	for (int n=0; n < 4; n++) {
+		CHECK(refs[n].resolve()->value == 3);
+	}
+
+	// All healed : a new reference on a is a reference on a.
+	hotswap_ptr<Value> onA(&a);
+	CHECK(onA.resolve()->value == 1);
+
+	// Eager swap leaves no forward behind, the entry of b is reused by d.
+	Value* pb = new Value(mgr, 20);
+	onA.hotSwapTo(pb);
+	CHECK(onA->value == 20);
+	onA		= 0;
+	delete pb;
+	Value* pd = new Value(mgr, 30);
+	hotswap_ptr<Value> again(&a);
+	CHECK(again.resolve()->value == 1);
+
+	// Forward to an object destroyed before the reference is used.
+	Value* pe = new Value(mgr, 40);
+	mgr->forwardObject(&a._trackMe, &pe->_trackMe);
+	delete pe;
+	Value* pf = new Value(mgr, 50);
+	CHECK(again.resolve()->value == 1);
+	delete pf;
+	delete pd;
+
+	again	= 0;
+	for (int n=0; n < 4; n++) {
+		refs[n] = 0;
+	}
+
+	// Swap onto an entry forwarded lazily : its forward stays, the chain goes on.
+	Value g(mgr, 60);
+	Value h(mgr, 70);
+	Value k(mgr, 80);
+	hotswap_ptr<Value> onG(&g);
+	hotswap_ptr<Value> onH(&h);
+	mgr->forwardObject(&h._trackMe, &k._trackMe);
+	mgr->forwardObject(&g._trackMe, &h._trackMe);
+	CHECK(onH.resolve()->value == 80);
+	CHECK(onG.resolve()->value == 80);
+
+	onG = &g;
+	onH = &h;
+	mgr->forwardObject(&h._trackMe, &k._trackMe);
+	CHECK(onG.hotSwapTo(&h));							// Eager swap onto h.
+	CHECK(onG.resolve()->value == 80);
+	CHECK(onH.resolve()->value == 80);
+
+	// Swap back : the chain is cut, no cycle.
+	onG = &g;
+	onH = &h;
+	mgr->forwardObject(&g._trackMe, &h._trackMe);
+	mgr->forwardObject(&h._trackMe, &g._trackMe);
+	CHECK(onG.resolve()->value == 60);
+	CHECK(onH.resolve()->value == 60);
+	onG = 0;
+	onH = 0;
+}
+
+//
+// Incremental swap : references not moved yet see the new object on a checked access.
+//
+void testIncremental(SwappableManager* mgr)
+{
+	Value a(mgr, 1);
+	Value b(mgr, 2);
+	hotswap_ptr<Value> refs[10];
+	for (int n=0; n < 10; n++) {
+		refs[n] = &a;
+	}
+
+	int calls = 0;
+	bool done = false;
+	while (!done && (calls < 10)) {
+		done = mgr->replaceObjectIncremental(&a._trackMe, &b._trackMe, 3);
+		calls++;
+		if (!done) {
+			int moved = 0;
+			for (int n=0; n < 10; n++) {
+				if (refs[n].operator->() == &b) {
+					moved++;
+				}
+			}
+			CHECK(moved == calls * 3);
+			CHECK(refs[9].resolve()->value == 2);	// Healed, whichever was moved.
+		}
+		if (calls == 1) {
+			refs[0] = 0;							// Removed during the swap.
+		}
+	}
+	CHECK(done && (calls <= 4));
+	for (int n=1; n < 10; n++) {
+		CHECK(refs[n]->value == 2);
+	}
+
+	// Forward removed at the end : a new reference on a stays on a.
+	hotswap_ptr<Value> onA(&a);
+	CHECK(onA.resolve()->value == 1);
+	onA = 0;
+
+	for (int n=0; n < 10; n++) {
+		refs[n] = 0;
+	}
+}
+
+#if LX_SWAPPABLE_VERSIONS > 0
+//
+// Reads at a tick : the ring keeps the last LX_SWAPPABLE_VERSIONS owners, oldest dropped first.
+void testVersions(SwappableManager* mgr)
+{
+	const int count = LX_SWAPPABLE_VERSIONS + 2;
+	Value* versions[count];
+	mgr->setTick(10);
+	for (int n=0; n < count; n++) {
+		versions[n] = new Value(mgr, n);
+	}
+	hotswap_ptr<Value> ref(versions[0]);
+	CHECK(ref.atTick(10) == versions[0]);
+
+	// Version n becomes current at tick 10 * (n + 1).
+	for (int n=1; n < count; n++) {
+		mgr->setTick(10 * (n + 1));
+		CHECK(ref.hotSwapTo(versions[n]));
+		CHECK(ref.atTick(10 * (n + 1))		== versions[n]);
+		CHECK(ref.atTick(10 * n + 5)		== versions[n - 1]);
+		if (n == 1) {
+			CHECK(ref.atTick(10)			== versions[0]);	// Ring not full yet.
+		}
+	}
+
+	// Ring wrapped : most recent first, the first version is older than the ring.
+	for (int n=1; n < count; n++) {
+		CHECK(ref.atTick(10 * (n + 1))		== versions[n]);
+		CHECK(ref.atTick(10 * (n + 1) + 5)	== versions[n]);
+	}
+	CHECK(ref.atTick(15)					== 0);
+	CHECK(ref.atTick(5)						== 0);
+
+	ref = 0;
+	for (int n=0; n < count; n++) {
+		delete versions[n];
+	}
+}
+#endif
+
+#ifdef TEST_ASSET
+// Asset built over the mapped file.
+class Texture : public SwappableMappedAsset {
+	MAKESWAPPABLE(Texture)
+public:
+	Texture(SwappableManager* mgr)
+	:_trackMe(this,mgr)
+	{
+	}
+};
+
+static Swappable* buildTexture(void* context, const void* data, size_t size)
+{
+	Texture* tex	= new Texture((SwappableManager*)context);
+	tex->m_data		= data;
+	tex->m_size		= size;
+	return &tex->_trackMe;
+}
+
+// Written aside and renamed, as the watcher expects.
+static bool replaceFile(const char* directory, const char* path, const char* content)
+{
+	char temp[SwappableAssetWatcher::MAX_PATH_LENGTH];
+	snprintf(temp, sizeof(temp), "%s/wall.tmp", directory);
+	FILE* file = fopen(temp, "wb");
+	if (!file) {
+		return false;
+	}
+	fwrite(content, 1, strlen(content), file);
+	fclose(file);
+	return rename(temp, path) == 0;
+}
+
+//
+// Hot reload of a file : the change is loaded on poll, swapped on drain.
+void testAsset(SwappableManager* mgr)
+{
+	char directory[] = "/tmp/lxassetXXXXXX";
+	if (!mkdtemp(directory)) {
+		printf("Asset watcher : no temporary directory, skipped.\n");
+		return;
+	}
+	char path[SwappableAssetWatcher::MAX_PATH_LENGTH];
+	snprintf(path, sizeof(path), "%s/wall.tex", directory);
+
+	size_t watcherSize			= SwappableAssetWatcher::getAllocSize(4);
+	unsigned char* watcherMem	= new unsigned char[watcherSize];
+	SwappableAssetWatcher watcher;
+	if (!watcher.init(watcherMem, watcherSize, 4, mgr)) {
+		printf("Asset watcher : inotify not available, skipped.\n");
+		delete[] watcherMem;
+		rmdir(directory);
+		return;
+	}
+
+	Texture* wall = new Texture(mgr);			// Not mapped.
+	hotswap_ptr<Texture> ref(wall);
+	CHECK(watcher.watch(path, &wall->_trackMe, &buildTexture, &SwappableAssetWatcher::destroyAsset<Texture>, mgr));
+	CHECK(watcher.poll() == 0);
+
+	// Swap is queued : the reference moves on drain, old asset is destroyed.
+	CHECK(replaceFile(directory, path, "v2"));
+	CHECK(watcher.poll() == 1);
+	CHECK(ref.operator->() == wall);
+	CHECK(mgr->drainSwaps() == 1);
+	CHECK((ref->m_size == 2) && (memcmp(ref->m_data, "v2", 2) == 0));
+
+	// Next change replaces the mapped asset, unmapped when destroyed.
+	CHECK(replaceFile(directory, path, "v3!"));
+	CHECK(watcher.poll() == 1);
+	CHECK(mgr->drainSwaps() == 1);
+	CHECK((ref->m_size == 3) && (memcmp(ref->m_data, "v3!", 3) == 0));
+
+	watcher.release();
+	delete[] watcherMem;
+	Texture* last = ref.operator->();
+	ref = 0;
+	SwappableAssetWatcher::destroyAsset<Texture>((void*)SwappableCast<Texture>::toOwner(last));
+	unlink(path);
+	rmdir(directory);
+}
+#endif
+
+//
+// Selective swaps : by group, and by filter on the reference address.
+//
+static bool inRange(void* context, const void* reference)
+{
+	const hotswap_ptr<Value>* range = (const hotswap_ptr<Value>*)context;
+	return (reference >= (const void*)&range[0]) && (reference < (const void*)&range[3]);
+}
+
+void testSelective(SwappableManager* mgr)
+{
+	Value a(mgr, 1);
+	Value b(mgr, 2);
+	Value c(mgr, 3);
+	hotswap_ptr<Value> refs[9];
+	for (int n=0; n < 9; n++) {
+		refs[n].setGroup(n % 3);
+		refs[n] = &a;
+	}
+
+	CHECK(mgr->replaceGroup(&a._trackMe, &b._trackMe, 1) == 3);
+	for (int n=0; n < 9; n++) {
+		CHECK(refs[n]->value == (((n % 3) == 1) ? 2 : 1));
+		CHECK(refs[n].getGroup() == (unsigned int)(n % 3));
+	}
+	CHECK(refs[0].resolve()->value == 1);		// Not forwarded.
+
+	// refs[0..2] : 0 and 2 still on a, 1 on b.
+	CHECK(mgr->replaceFiltered(&a._trackMe, &c._trackMe, &inRange, refs) == 2);
+	CHECK((refs[0]->value == 3) && (refs[1]->value == 2) && (refs[2]->value == 3));
+	CHECK(refs[3]->value == 1);
+
+	// Highest group, and one above : refused, the reference keeps its group.
+	const unsigned int last = SwappableManager::MAX_GROUP;
+	CHECK(refs[3].setGroup(last));
+	CHECK(!refs[3].setGroup(last + 1));
+	CHECK(refs[3].getGroup() == last);
+	CHECK(mgr->replaceGroup(&a._trackMe, &c._trackMe, last + 1) == 0);
+	CHECK(mgr->replaceGroup(&a._trackMe, &c._trackMe, last) == 1);
+	CHECK((refs[3]->value == 3) && (refs[6]->value == 1));
+
+	for (int n=0; n < 9; n++) {
+		refs[n] = 0;
+	}
+}
+
+//
+// A/B routing : split ratio, per variant counters, rollback and promote.
+//
+void testRouter(SwappableManager* mgr)
+{
+	const int count = 20;
+	Value a(mgr, 1);
+	Value b(mgr, 2);
+	SwappableRouter router;
+	hotswap_routed_ptr<Value> refs[count];
+	for (int n=0; n < count; n++) {
+		refs[n].setRouter(&router);
+		refs[n] = &a;
+	}
+
+	CHECK(router.split(&a, &b, 10) == 2);
+	const SwappableRouter::STATS& statsA = router.getStats(SwappableRouter::VARIANT_A);
+	const SwappableRouter::STATS& statsB = router.getStats(SwappableRouter::VARIANT_B);
+	CHECK((statsA.m_references == 18) && (statsB.m_references == 2));
+
+	int sum = 0;
+	for (int n=0; n < count; n++) {
+		sum += refs[n]->value;
+	}
+	CHECK(sum == 22);
+	CHECK((statsA.m_calls == 18) && (statsB.m_calls == 2));
+
+	CHECK(router.rollback() == 2);
+	for (int n=0; n < count; n++) {
+		CHECK(refs[n].get() == &a);
+	}
+	CHECK((statsA.m_references == 20) && (statsB.m_references == 0));
+
+	CHECK(router.split(&a, &b, 50) == 10);
+	CHECK(router.promote() == 10);
+	for (int n=0; n < count; n++) {
+		CHECK(refs[n].get() == &b);
+	}
+	CHECK((statsA.m_references == 0) && (statsB.m_references == 20));
+
+	for (int n=0; n < count; n++) {
+		refs[n] = 0;
+	}
+}
+
+#ifndef LX_SWAPPABLE_NO_STAGING
+//
+// Objects and references built in a staging manager, merged in the live one.
+//
+void testStaging(SwappableManager* mgr)
+{
+	SwappableManager staging;
+	size_t stagingSize			= SwappableManager::getAllocSize(16);
+	unsigned char* stagingMem	= new unsigned char[stagingSize];
+	size_t trackerSize			= SwappableManager::getStagingAllocSize(16);
+	unsigned char* trackerMem	= new unsigned char[trackerSize];
+	staging.init(stagingMem, stagingSize, 16);
+	CHECK(staging.enableStaging(trackerMem, trackerSize));
+	CHECK(!mgr->merge(mgr));
+
+	Value live(mgr, 0);
+	Value* loaded[8];
+	hotswap_ptr<Value> refs[8];
+	for (int round=0; round < 2; round++) {
+		for (int n=0; n < 4; n++) {
+			Value* obj = new Value(&staging, round * 4 + n);
+			loaded[round * 4 + n]	= obj;
+			refs[round * 4 + n]		= obj;
+		}
+		refs[round * 4 + 1]   = 0;
+		delete loaded[round * 4 + 1];				// Hole left in the staging entries.
+		loaded[round * 4 + 1] = 0;
+
+		CHECK(mgr->merge(&staging));
+		for (int n=0; n < 4; n++) {
+			Value* obj = loaded[round * 4 + n];
+			if (obj) {
+				CHECK(obj->_trackMe.getManager() == mgr);
+				CHECK(refs[round * 4 + n]->value == round * 4 + n);
+			}
+		}
+	}
+
+	// Merged references are in the live lists.
+	Value other(mgr, 100);
+	CHECK(refs[6].hotSwapTo(&other));
+	CHECK(refs[6]->value == 100);
+	CHECK(refs[2]->value == 2);
+
+	for (int n=0; n < 8; n++) {
+		refs[n] = 0;
+		delete loaded[n];
+	}
+	staging.release();
+	delete[] trackerMem;
+	delete[] stagingMem;
+}
+#endif
+
+//
+// Owning references keep their count on every kind of swap.
+//
+void testShared(SwappableManager* mgr)
+{
+	Value* a = new Value(mgr, 1);
+	Value* b = new Value(mgr, 2);
+	hotswap_shared_ptr<Value> owner(a);
+	hotswap_ptr<Value> ref(a);
+	ref.setGroup(1);
+
+	// Selective swap leaves an owned object untouched.
+	CHECK(mgr->replaceGroup(&a->_trackMe, &b->_trackMe, 1) == 0);
+	CHECK(ref->value == 1);
+
+	// Lazy swap of an owned object is done at once, owners included.
+	mgr->forwardObject(&a->_trackMe, &b->_trackMe);
+	CHECK((owner->value == 2) && (ref->value == 2));
+	CHECK(owner.useCount() == 1);
+	delete a;
+
+	// Incremental swap of an owned object finishes in one call.
+	Value* c = new Value(mgr, 3);
+	CHECK(mgr->replaceObjectIncremental(&b->_trackMe, &c->_trackMe, 1));
+	CHECK((owner->value == 3) && (owner.useCount() == 1));
+	delete b;
+
+	// Owner added after the forward : moved with the others on the first checked access.
+	Value* d = new Value(mgr, 4);
+	Value* e = new Value(mgr, 5);
+	hotswap_ptr<Value> onD(d);
+	mgr->forwardObject(&d->_trackMe, &e->_trackMe);
+	hotswap_shared_ptr<Value> late(d);
+	CHECK(onD.resolve()->value == 5);
+	CHECK((late->value == 5) && (late.useCount() == 1));
+	delete d;
+
+	// Last owners retire c and e (destroyed now : no retire handler).
+	ref		= 0;
+	onD		= 0;
+	owner	= 0;
+	late	= 0;
+}
+
+// Object retiring the next one of its chain when destroyed.
+struct Link {
+	Link*				next;
+	SwappableHazard*	hazard;
+};
+
+static int g_linkDestroyed = 0;
+
+static void destroyLink(void* object)
 {
-	hotswap_ptr<Sample> g_helloSwappable;
-	hotswap_ptr<Sample> g_helloSwappable2;
-	hotswap_ptr<Sample> g_helloSwappable3;
+	Link* link = (Link*)object;
+	if (link->next) {
+		link->hazard->retire(link->next, &destroyLink);
+	}
+	delete link;
+	g_linkDestroyed++;
+}
+
+//
+// Hazard domain : protected objects survive the scan, destructors retiring other
+// objects from inside scan destroy each object once.
+//
+void testHazard(SwappableManager* mgr)
+{
+	int hazardSize			= SwappableHazard::getAllocSize(1, 2);
+	unsigned char* hazardMem= new unsigned char[hazardSize];
+	SwappableHazard hazard;
+	CHECK(hazard.init(hazardMem, hazardSize, 1, 2));
+
+	Value* a = new Value(mgr, 1);
+	hotswap_ptr<Value> ref(a);
+	int slot = hazard.acquireSlot();
+	CHECK(slot == 0);
+	CHECK(hazard.protect(slot, ref) == a);
+	CHECK(hazard.acquireSlot() == -1);
+	ref = 0;
+	hazard.retire(a, &SwappableManager::destroyObject<Value>);
+	CHECK(hazard.scan() == 0);						// Still protected.
+	hazard.releaseSlot(slot);
+	CHECK(hazard.scan() == 1);
+
+	const int chains = 3;
+	const int length = 4;
+	for (int c=0; c < chains; c++) {
+		Link* head = 0;
+		for (int n=0; n < length; n++) {
+			Link* link	= new Link;
+			link->next	= head;
+			link->hazard= &hazard;
+			head		= link;
+		}
+		hazard.retire(head, &destroyLink);
+	}
+	hazard.scan();
+	hazard.release();
+	CHECK(g_linkDestroyed == chains * length);
+
+	delete[] hazardMem;
+}
+
+// Second base of swappable classes, not the owner.
+struct Listener {
+	int events;
+};
+
+class Player : public Value, public Listener {
+public:
+	Player(SwappableManager* mgr, int v, int e)
+	:Value(mgr, v)
+	{
+		events = e;
+	}
+};
+
+// Same bases in another order : the conversion differs.
+class Spectator : public Listener, public Value {
+public:
+	Spectator(SwappableManager* mgr, int v, int e)
+	:Value(mgr, v)
+	{
+		events = e;
+	}
+};
+
+//
+// One object referenced through the owner, a derived class and a second base.
+//
+void testBase(SwappableManager* mgr)
+{
+	Player p1(mgr, 1, 10);
+	Player p2(mgr, 2, 20);
+	Spectator s(mgr, 3, 30);
+	hotswap_ptr< swappable_base<Listener> > onListener(&p1);
+	hotswap_ptr<Value>  onValue (&p1);
+	hotswap_ptr<Player> onPlayer(&p1);
+	CHECK(sizeof(onListener) == sizeof(onValue) + sizeof(void*));
+	CHECK(onListener.get() == static_cast<Listener*>(&p1));
+	CHECK(onListener->events == 10);
+
+	CHECK(onListener.hotSwapTo(&p2));
+	CHECK((onListener->events == 20) && (onValue->value == 2) && (onPlayer.operator->() == &p2));
+	CHECK(!onListener.hotSwapTo(&s));						// Other class : refused.
+	CHECK(onListener->events == 20);
 
+	hotswap_ptr< swappable_base<Listener> > copy(onListener);
+	mgr->forwardObject(&p2._trackMe, &p1._trackMe);
+	CHECK(copy.resolve()->events == 10);
+	CHECK(onListener.resolve() == static_cast<Listener*>(&p1));
+
+	onListener = &s;
+	CHECK(onListener.get() == static_cast<Listener*>(&s));
+	CHECK(onListener->events == 30);
+
+	onListener	= 0;
+	CHECK(onListener.get() == 0);
+	copy		= 0;
+	onValue		= 0;
+	onPlayer	= 0;
+}
+
+//
+// Reference read from other threads : published by the swap, protected by a hazard
+// slot while the old object is retired.
+//
+void testAtomic(SwappableManager* mgr)
+{
+	int hazardSize			= SwappableHazard::getAllocSize(2, 4);
+	unsigned char* hazardMem= new unsigned char[hazardSize];
+	SwappableHazard hazard;
+	CHECK(hazard.init(hazardMem, hazardSize, 2, 4));
+
+	Value* a = new Value(mgr, 1);
+	Value* b = new Value(mgr, 2);
+	hotswap_atomic_ptr<Value> shared(a);
+	CHECK(shared.get() == a);
+
+	int slot = hazard.acquireSlot();
+	Value* held = hazard.protect(slot, shared);
+	CHECK(held == a);
+	CHECK(shared.hotSwapTo(b));
+	CHECK((shared.get() == b) && (shared->value == 2));
+	hazard.retire(a, &SwappableManager::destroyObject<Value>);
+	CHECK(hazard.scan() == 0);
+	CHECK(held->value == 1);							// Still alive for the reader.
+	hazard.releaseSlot(slot);
+	CHECK(hazard.scan() == 1);
+
+#ifdef TEST_CPP20
+	// Reader thread sees either object, never anything else.
+	Value c(mgr, 3);
+	int bad = 0;
+	std::thread reader([&]() {
+		for (int n=0; n < 100000; n++) {
+			int v = shared->value;
+			if ((v != 2) && (v != 3)) {
+				bad++;
+			}
+		}
+	});
+	for (int n=0; n < 1000; n++) {
+		shared.hotSwapTo((n & 1) ? b : &c);
+	}
+	reader.join();
+	CHECK(bad == 0);
+#endif
+
+	shared = 0;
+	delete b;
+	hazard.release();
+	delete[] hazardMem;
+}
+
+// Holder of references saved in an image.
+struct Record {
+	hotswap_ptr<Value> target;
+};
+
+//
+// References saved in an image and linked back to loaded objects, groups included.
+//
+void testArchive(SwappableManager* mgr)
+{
+	const int count = 6;
+	Value a(mgr, 1);
+	Value b(mgr, 2);
+	Record live[count];
+	for (int n=0; n < count; n++) {
+		live[n].target = (n & 1) ? &b : &a;
+		live[n].target.setGroup(n & 1);
+	}
+
+	size_t saverSize		= SwappableSaver::getAllocSize(64);
+	unsigned char* saverMem	= new unsigned char[saverSize];
+	SwappableSaver saver;
+	CHECK(saver.init(saverMem, saverSize, mgr));
+	saver.setId(&a, 0);
+	saver.setId(&b, 1);
+
+	unsigned char* imageMem	= new unsigned char[sizeof(Record) * count];
+	Record* image			= (Record*)imageMem;
+	SwappableFixup fixups[count];
+	size_t fixupCount		= 0;
+	for (int n=0; n < count; n++) {
+		memcpy((void*)&image[n], (const void*)&live[n], sizeof(Record));
+		if (saver.saveReference(live[n].target, &image[n].target, image, &fixups[fixupCount])) {
+			fixupCount++;
+		}
+	}
+	CHECK(fixupCount == (size_t)count);
+
+	// Load against other objects.
+	Value loadedA(mgr, 10);
+	Value loadedB(mgr, 20);
+	size_t loaderSize		= SwappableLoader::getAllocSize(2);
+	unsigned char* loaderMem= new unsigned char[loaderSize];
+	SwappableLoader loader;
+	CHECK(loader.init(loaderMem, loaderSize, 2, mgr));
+	CHECK(loader.setObject(0, &loadedA));
+	CHECK(loader.setObject(1, &loadedB));
+	CHECK(!loader.setObject(2, &loadedA));
+	CHECK(loader.swizzle(image, fixups, fixupCount));
+	for (int n=0; n < count; n++) {
+		CHECK(image[n].target->value == ((n & 1) ? 20 : 10));
+		CHECK(image[n].target.getGroup() == (unsigned int)(n & 1));
+	}
+
+	// Linked in the live lists : a swap moves them.
+	Value c(mgr, 30);
+	CHECK(mgr->replaceGroup(&loadedB._trackMe, &c._trackMe, 1) == (size_t)(count / 2));
+	hotswap_ptr<Value> onA(&loadedA);
+	CHECK(onA.hotSwapTo(&c));
+	for (int n=0; n < count; n++) {
+		CHECK(image[n].target->value == 30);
+		image[n].target = 0;
+	}
+	onA = 0;
+
+	delete[] loaderMem;
+	delete[] imageMem;
+	delete[] saverMem;
+}
+
+//
+// Group members unlinked together without touching the other references of the
+// same targets, batch assigned references moved by a later swap.
+//
+void testGroup(SwappableManager* mgr)
+{
+	Value a(mgr, 1);
+	Value b(mgr, 2);
+	Value c(mgr, 3);
+	hotswap_ptr<Value> outside[4];
+	{
+		hotswap_ptr<Value> members[8];
+		hotswap_group<8> group;					// Declared after the members : destroyed first.
+		for (int n=0; n < 8; n++) {
+			members[n] = (n & 1) ? &b : &a;
+			CHECK(group.add(members[n]));
+			if ((n & 1) == 0) {
+				outside[n / 2] = (n & 2) ? &b : &a;	// Interleaved in the same lists.
+			}
+		}
+		members[3] = 0;							// Registered but not linked.
+		CHECK(group.unlinkAll() == 7);
+		for (int n=0; n < 8; n++) {
+			CHECK(members[n].resolve() == 0);
+		}
+		CHECK(group.getCount() == 0);
+	}
+	CHECK(outside[0].hotSwapTo(&c));
+	CHECK(outside[1].hotSwapTo(&c));
+	for (int n=0; n < 4; n++) {
+		CHECK(outside[n]->value == 3);
+	}
+
+	// Batch over references of several targets, then the new target is swapped.
+	Value d(mgr, 4);
+	Value e(mgr, 5);
+	size_t batchSize			= SwappableReferenceBatch::getAllocSize(8);
+	unsigned char* batchMem		= new unsigned char[batchSize];
+	SwappableReferenceBatch batch;
+	CHECK(batch.init(batchMem, batchSize, 8));
+	hotswap_ptr<Value> refs[8];
+	for (int n=0; n < 8; n++) {
+		refs[n] = (n < 4) ? &c : 0;
+		CHECK(batch.add(refs[n]));
+	}
+	CHECK(batch.assign(&d) == 8);
+	CHECK(refs[7].hotSwapTo(&e));
+	for (int n=0; n < 8; n++) {
+		CHECK(refs[n]->value == 5);
+	}
+	for (int n=0; n < 4; n++) {
+		CHECK(outside[n]->value == 3);				// Left in the list of c.
+		outside[n] = 0;
+	}
+	CHECK(batch.assign((Value*)0) == 8);
+	for (int n=0; n < 8; n++) {
+		CHECK(refs[n].resolve() == 0);
+	}
+
+	// References of another type are left alone, even when their tracker code is identical.
+	Sample s(mgr);
+	hotswap_ptr<Sample> other(&s);
+	batch.clear();
+	CHECK(batch.add(refs[0]));
+	CHECK(batch.add(other));
+	CHECK(batch.assign(&d) == 1);
+	CHECK((refs[0]->value == 4) && (other.resolve() == &s));
+	CHECK(batch.assign((Value*)0) == 1);
+	CHECK(other.resolve() == &s);
+	other = 0;
+
+	delete[] batchMem;
+}
+
+#ifdef LX_SWAPPABLE_PERF
+//
+// Instrumentation : one call per operation, nested ones included, with or without hardware counters.
+void testPerf(SwappableManager* mgr)
+{
+	SwappablePerf perf;
+	bool hardware = perf.init();
+	CHECK(perf.hasHardwareCounters() == hardware);
+	mgr->setPerf(&perf);
+
+	Value* a = new Value(mgr, 1);
+	Value* b = new Value(mgr, 2);
+	Value* c = new Value(mgr, 3);
+	hotswap_shared_ptr<Value> owner(a);
+	hotswap_ptr<Value> ref(a);
+	CHECK(perf.getCounters(SwappablePerf::OP_REGISTER).m_calls == 3);
+	CHECK(perf.getCounters(SwappablePerf::OP_ATTACH_REFERENCE).m_calls >= 1);
+
+	// Lazy and incremental swaps of an owned object end in a plain swap : counted once each.
+	mgr->forwardObject(&a->_trackMe, &b->_trackMe);
+	CHECK(perf.getCounters(SwappablePerf::OP_REPLACE_OBJECT).m_calls == 1);
+	CHECK(mgr->replaceObjectIncremental(&b->_trackMe, &c->_trackMe, 1));
+	CHECK(perf.getCounters(SwappablePerf::OP_REPLACE_OBJECT).m_calls == 2);
+	CHECK((owner->value == 3) && (ref->value == 3));
+
+	// Unregistration has its own counters.
+	delete a;
+	delete b;
+	CHECK(perf.getCounters(SwappablePerf::OP_UNREGISTER).m_calls == 2);
+	CHECK(perf.getCounters(SwappablePerf::OP_REGISTER).m_calls == 3);
+	if (hardware) {
+		CHECK(perf.getCounters(SwappablePerf::OP_REPLACE_OBJECT).m_instructions > 0);
+	}
+
+	// Timing only : calls are still counted, hardware values stay 0.
+	perf.release();
+	perf.reset();
+	CHECK(!perf.hasHardwareCounters());
+	Value* d = new Value(mgr, 4);
+	ref.hotSwapTo(d);
+	CHECK(ref->value == 4);
+	const SwappablePerf::COUNTERS& swaps = perf.getCounters(SwappablePerf::OP_REPLACE_OBJECT);
+	CHECK((swaps.m_calls == 1) && (swaps.m_cycles == 0) && (swaps.m_instructions == 0));
+	delete c;
+
+	// Last owner destroys d.
+	mgr->setPerf(0);
+	ref		= 0;
+	owner	= 0;
+}
+#endif
+
+// Pool running the jobs on the calling thread, last index first.
+static int g_poolMaxCount = 0;
+
+static void reverseParallelFor(void* context, int count, void (*job)(void* arg, int index), void* arg)
+{
+	(void)context;
+	if (count > g_poolMaxCount) {
+		g_poolMaxCount = count;
+	}
+	for (int n=count-1; n >= 0; n--) {
+		job(arg, n);
+	}
+}
+
+//
+// Dependency graph over two managers : levels in order, one lane per manager.
+//
+void testScheduler(SwappableManager* mgrA, SwappableManager* mgrB)
+{
+	Value mesh1(mgrA, 1), mesh2(mgrA, 2);
+	Value mat1 (mgrA, 3), mat2 (mgrA, 4);
+	Value anim1(mgrA, 5), anim2(mgrA, 6);
+	Value tex1 (mgrB, 7), tex2 (mgrB, 8), tex3(mgrB, 9);
+	hotswap_ptr<Value> onMesh(&mesh1);
+	hotswap_ptr<Value> onMat (&mat1);
+	hotswap_ptr<Value> onAnim(&anim1);
+	hotswap_ptr<Value> onTex (&tex1);
+
+	int schedSize			= SwappableScheduler::getAllocSize(8, 8);
+	unsigned char* schedMem	= new unsigned char[schedSize];
+	SwappableScheduler sched;
+	CHECK(sched.init(schedMem, schedSize, 8, 8));
+	CHECK(sched.addSwap(&mesh1, &tex2) == -1);	// Objects of two managers.
+	int mesh	= sched.addSwap(&mesh1, &mesh2);
+	int mat		= sched.addSwap(&mat1,  &mat2 );
+	CHECK(sched.addSwap(&anim1, &anim2) >= 0);
+	int texA	= sched.addSwap(&tex1,  &tex2 );
+	int texB	= sched.addSwap(&tex2,  &tex3 );	// Chained : tex1 references end on tex3.
+	CHECK(sched.addDependency(mesh, mat));
+	CHECK(sched.addDependency(texA, texB));
+	CHECK(sched.addDependency(texB, mat));
+
+	// Cycle : nothing is swapped.
+	CHECK(sched.addDependency(mat, mesh));
+	CHECK(!sched.run(0));
+	CHECK(onMesh->value == 1);
+
+	sched.clear();
+	mesh	= sched.addSwap(&mesh1, &mesh2);
+	mat		= sched.addSwap(&mat1,  &mat2 );
+	CHECK(sched.addSwap(&anim1, &anim2) >= 0);
+	texA	= sched.addSwap(&tex1,  &tex2 );
+	texB	= sched.addSwap(&tex2,  &tex3 );
+	CHECK(sched.addDependency(mesh, mat));
+	CHECK(sched.addDependency(texA, texB));
+	CHECK(sched.addDependency(texB, mat));
+
+	SwappableJobPool pool;
+	pool.m_parallelFor	= &reverseParallelFor;
+	pool.m_context		= 0;
+	CHECK(sched.run(&pool));
+	CHECK(sched.getLevelCount() == 3);
+	CHECK(sched.getMaxLaneCount() == 2);		// mesh and anim share a lane.
+	CHECK(g_poolMaxCount == 2);
+	CHECK((onMesh->value == 2) && (onMat->value == 4) && (onAnim->value == 6) && (onTex->value == 9));
+
+	onMesh	= 0;
+	onMat	= 0;
+	onAnim	= 0;
+	onTex	= 0;
+	delete[] schedMem;
+}
+
+//
+// Staged swaps are seen by handles only after the flip, chained, and cancelled
+// when the target dies before the flip.
+//
+void testBanks(SwappableManager* mgr, void* bankMem, size_t bankSize)
+{
+	CHECK(mgr->enableBanks(bankMem, bankSize));
+
+	Value a(mgr, 1);
+	Value b(mgr, 2);
+	Value c(mgr, 3);
+	hotswap_handle<Value> onA(&a);
+	hotswap_handle<Value> onB(&b);
+
+	mgr->stageSwap(&a._trackMe, &b._trackMe);
+	CHECK(onA->value == 1);
+	mgr->stageSwap(&b._trackMe, &c._trackMe);
+	CHECK((onA->value == 1) && (onB->value == 2));
+	mgr->flipBanks();
+	CHECK((onA->value == 3) && (onB->value == 3));
+
+	// Read section : both handles from the same flip.
+	unsigned int bank = mgr->enterRead();
+	CHECK(mgr->resolveHandle(a._trackMe.getSlot(), bank) == mgr->resolveHandle(b._trackMe.getSlot(), bank));
+	mgr->leaveRead(bank);
+	CHECK(mgr->trySyncBanks());
+
+	// Back to themselves, then a staged target destroyed before the flip.
+	mgr->stageSwap(&a._trackMe, &a._trackMe);
+	mgr->stageSwap(&b._trackMe, &b._trackMe);
+	mgr->flipBanks();
+	CHECK((onA->value == 1) && (onB->value == 2));
+	{
+		Value d(mgr, 4);
+		mgr->stageSwap(&a._trackMe, &d._trackMe);
+	}
+	Value reused(mgr, 5);
+	mgr->flipBanks();
+	CHECK(onA->value == 1);
+}
+
+//
+// External table at several load factors : every registered object is found, removed
+// ones are not. With bench, also print the lookup time.
+//
+void testExternal(bool bench)
+{
+	const int maxObjects	= 58000;	// Fills a 64K entries table at 88%.
+	const int lookups		= 1 << 22;
+
+	SwappableManager mgr;
+	size_t mgrSize			= SwappableManager::getAllocSize(maxObjects);
+	unsigned char* mgrMem	= new unsigned char[mgrSize];
+	mgr.init(mgrMem, mgrSize, maxObjects);
+
+	SwappableExternal table;
+	size_t tableSize		= SwappableExternal::getAllocSize(maxObjects);
+	unsigned char* tableMem	= new unsigned char[tableSize];
+	CHECK(table.init(tableMem, tableSize, maxObjects, &mgr));
+
+	ThirdParty* objects		= new ThirdParty[maxObjects];
+	const int steps[]		= { maxObjects / 4, maxObjects / 2, (maxObjects * 3) / 4, maxObjects };
+	int registered			= 0;
+	for (int s=0; s < 4; s++) {
+		while (registered < steps[s]) {
+			CHECK(table.add(&objects[registered++]));
+		}
+		CHECK(!table.add(&objects[0]));
+
+		int found = 0;
+		SwappableIndex handle;
+		for (int n=0; n < maxObjects; n++) {
+			if (table.find(&objects[n], handle)) {
+				found++;
+			}
+		}
+		CHECK(found == registered);
+
+		if (bench) {
+			// Random order, not the allocation order.
+			unsigned int rnd		= 12345;
+			SwappableIndex sum		= 0;
+			unsigned long long start = SwappablePerf::now();
+			for (int n=0; n < lookups; n++) {
+				rnd = rnd * 1664525 + 1013904223;
+				if (table.find(&objects[rnd % registered], handle)) {
+					sum += handle;
+				}
+			}
+			unsigned long long time = SwappablePerf::now() - start;
+			printf("External lookup, load %.2f : %.2f ns (%u)\n",
+				(double)table.getCount() / table.getCapacity(),
+				(double)time / lookups,
+				(unsigned int)sum);
+		}
+	}
+
+	// Every other object removed : the others are still found past the holes.
+	for (int n=0; n < registered; n += 2) {
+		CHECK(table.remove(&objects[n]));
+	}
+	for (int n=0; n < registered; n++) {
+		SwappableIndex handle;
+		CHECK(table.find(&objects[n], handle) == ((n & 1) != 0));
+	}
+	CHECK(!table.remove(&objects[0]));
+
+	// Swap of an external object : all its references move, through the pointer and the table.
+	objects[1].value = 1;
+	objects[3].value = 3;
+	objects[5].value = 5;
+	hotswap_ptr< swappable_extern<ThirdParty> > refs[4];
+	for (int n=0; n < 4; n++) {
+		refs[n] = &objects[1];
+	}
+	hotswap_ptr< swappable_extern<ThirdParty> > copy(refs[0]);
+	hotswap_ptr< swappable_extern<ThirdParty> > unknown(&objects[0]);	// Removed : NULL.
+	CHECK(unknown.get() == 0);
+	CHECK(!refs[0].hotSwapTo(&objects[0]));
+	CHECK(!unknown.hotSwapTo(&objects[3]));
+	CHECK(refs[0]->value == 1);
+	CHECK(refs[2].hotSwapTo(&objects[3]));
+	for (int n=0; n < 4; n++) {
+		CHECK(refs[n].get() == &objects[3]);
+	}
+	CHECK(copy->value == 3);
+	CHECK(table.replace(&objects[3], &objects[5]));
+	CHECK(!table.replace(&objects[5], &objects[0]));
+	for (int n=0; n < 4; n++) {
+		CHECK(refs[n]->value == 5);
+	}
+	CHECK(copy.get() == &objects[5]);
+
+	// Old object has no reference left : a new one on it is alone in its list.
+	hotswap_ptr< swappable_extern<ThirdParty> > onOld(&objects[1]);
+	CHECK(table.replace(&objects[1], &objects[7]));
+	CHECK((onOld.get() == &objects[7]) && (refs[0].get() == &objects[5]));
+	onOld	= 0;
+	copy	= 0;
+	for (int n=0; n < 4; n++) {
+		refs[n] = 0;
+	}
+
+	for (int n=1; n < registered; n += 2) {
+		table.remove(&objects[n]);
+	}
+	CHECK(table.getCount() == 0);
+	table.release();
+	delete[] objects;
+	delete[] tableMem;
+	delete[] mgrMem;
+}
+
+int main(int argc, char* argv[])
+{
 	SwappableManager* pMgr = new SwappableManager();
-	int size = SwappableManager::getAllocSize(5000);
-	pMgr->init(new unsigned char[size], size, 5000);
-	Sample* sample = new Sample(pMgr);
+	size_t size = SwappableManager::getAllocSize(5000);
+	unsigned char* mgrMem = new unsigned char[size];
+	pMgr->init(mgrMem, size, 5000);
+
+	// Replaced objects are destroyed at flush time instead of inside the swap.
+	SwappableRetireQueue retireQueue;
+	int retireSize = SwappableRetireQueue::getAllocSize(16);
+	unsigned char* retireMem = new unsigned char[retireSize];
+	retireQueue.init(retireMem, retireSize, 16);
+	retireQueue.attach(pMgr);
+
+	{
+		// Owner of the sample, references are declared after : released first.
+		hotswap_unique_ptr<Sample> g_sampleOwner(new Sample(pMgr));
+
+		hotswap_ptr<Sample> g_helloSwappable;
+		hotswap_ptr<Sample> g_helloSwappable2;
+		hotswap_ptr<Sample> g_helloSwappable3;
+
+		Sample* sample = g_sampleOwner.get();
+
+		g_helloSwappable	= sample;
+		g_helloSwappable2	= sample;
+		g_helloSwappable3	= sample;
+
+		g_helloSwappable2	= 0;
 
-	g_helloSwappable	= sample;
-	g_helloSwappable2	= sample;
-	g_helloSwappable3	= sample;
+		g_helloSwappable	= 0;
 
-	g_helloSwappable2	= 0;
+		// All references move to the new sample, the old one is retired.
+		g_sampleOwner.hotSwapTo(new Sample(pMgr));
+		retireQueue.flush(-1);
+	}
 
-	g_helloSwappable	= 0;
+	retireQueue.release();
+	pMgr->release();
+	delete[] retireMem;
+	delete[] mgrMem;
+	delete pMgr;
 
-	g_helloSwappable3.hotSwapTo(new Sample(pMgr));
+	{
+		SwappableManager mgr;
+		size_t mgrSize			= SwappableManager::getAllocSize(64);
+		unsigned char* mgrMem	= new unsigned char[mgrSize];
+		mgr.init(mgrMem, mgrSize, 64);
+		testIncremental(&mgr);
+		testForward(&mgr);
+#if LX_SWAPPABLE_VERSIONS > 0
+		testVersions(&mgr);
+#endif
+		testShared(&mgr);
+		testBase(&mgr);
+		testHazard(&mgr);
+		testAtomic(&mgr);
+		testInPlace(&mgr);
+		testArchive(&mgr);
+		testGroup(&mgr);
+		testSelective(&mgr);
+		testRouter(&mgr);
+#ifdef LX_SWAPPABLE_PERF
+		testPerf(&mgr);
+#endif
+#ifndef LX_SWAPPABLE_NO_STAGING
+		testStaging(&mgr);
+#endif
+#ifdef TEST_ASSET
+		testAsset(&mgr);
+#endif
+		mgr.release();
+		delete[] mgrMem;
+	}
+
+	{
+		SwappableManager mgr;
+		size_t mgrSize			= SwappableManager::getAllocSize(64);
+		unsigned char* mgrMem	= new unsigned char[mgrSize];
+		size_t bankSize			= SwappableManager::getBankAllocSize(64);
+		unsigned char* bankMem	= new unsigned char[bankSize];
+		mgr.init(mgrMem, mgrSize, 64);
+		testBanks(&mgr, bankMem, bankSize);
+		mgr.release();
+		delete[] bankMem;
+		delete[] mgrMem;
+	}
+
+	// Compact 32 bits handles have a single manager.
+#if !(defined(LX_SWAPPABLE_COMPACT) && (LX_SWAPPABLE_INDEX_BITS == 32))
+	{
+		SwappableManager mgrA;
+		SwappableManager mgrB;
+		size_t mgrSize			= SwappableManager::getAllocSize(64);
+		unsigned char* memA		= new unsigned char[mgrSize];
+		unsigned char* memB		= new unsigned char[mgrSize];
+		mgrA.init(memA, mgrSize, 64);
+		mgrB.init(memB, mgrSize, 64);
+		testScheduler(&mgrA, &mgrB);
+		mgrB.release();
+		mgrA.release();
+		delete[] memB;
+		delete[] memA;
+	}
+#endif
+
+#ifdef TEST_CPP20
+	{
+		SwappableManager mgr;
+		size_t mgrSize			= SwappableManager::getAllocSize(64);
+		unsigned char* mgrMem	= new unsigned char[mgrSize];
+		mgr.init(mgrMem, mgrSize, 64);
+		testCpp20(&mgr);
+		mgr.release();
+		delete[] mgrMem;
+	}
+#endif
+
+	// "-bench" also prints the external table lookup time.
+	testExternal((argc > 1) && (strcmp(argv[1], "-bench") == 0));
 
 	/*
 	MyClass aClass(NULL);
@@ -38,6 +1368,10 @@ int main(int argc, char* argv[])
 	TRACK_ASSIGN(bClass.myClass, &aClass);
 	*/
 
+	if (g_failures) {
+		printf("%d check(s) failed\n", g_failures);
+		return 1;
+	}
 	return 0;
 }
 